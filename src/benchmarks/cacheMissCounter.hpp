@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//Hardware cache miss counter of the calling process, read through perf events on Linux.
+//Open it before the first parallel loop, worker threads only inherit counters that exist when they start.
+//Where counters are not available (other platforms, containers, perf_event_paranoid) available() is false.
+class CacheMissCounter
+{
+public:
+	CacheMissCounter()
+	{
+#ifdef __linux__
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+
+		attributes.type = PERF_TYPE_HARDWARE;
+		attributes.size = sizeof(attributes);
+		attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+		attributes.disabled = 1;
+		attributes.inherit = 1;
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+
+		descriptor = (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+	}
+
+	~CacheMissCounter()
+	{
+#ifdef __linux__
+		if (descriptor >= 0) close(descriptor);
+#endif
+	}
+
+	CacheMissCounter(const CacheMissCounter &) = delete;
+	CacheMissCounter &operator=(const CacheMissCounter &) = delete;
+
+	bool available() const { return descriptor >= 0; }
+
+	void start()
+	{
+#ifdef __linux__
+		if (descriptor < 0) return;
+
+		ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+		ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+	}
+
+	//Misses counted since start()
+	uint64_t stop()
+	{
+		uint64_t misses = 0;
+
+#ifdef __linux__
+		if (descriptor < 0) return 0;
+
+		ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+		if (read(descriptor, &misses, sizeof(misses)) != sizeof(misses)) misses = 0;
+#endif
+
+		return misses;
+	}
+
+private:
+	int descriptor = -1;
+};
@@ -0,0 +1,349 @@
+#include "solvers/solver.hpp"
+#include "solvers/pressureSolver.hpp"
+#include "helpers/clock.hpp"
+#include "benchmarks/cacheMissCounter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct BenchmarkOptions
+{
+	std::vector<int> sizes = { 1000, 10000, 100000, 1000000 };
+	std::vector<std::string> curves = { "XYZ", "ZIndex", "HILBERT" };
+	std::vector<std::string> cellLookups = { "hashed" };
+	int repetitions = 10;
+	int reorderInterval = 1;
+	bool pairCache = true;
+	bool symmetric = false;
+	bool listFree = false;
+};
+
+struct BenchmarkResult
+{
+	double meanNsPerParticle = 0.0;
+	double varianceNsPerParticle = 0.0;
+	double particlesPerSecond = 0.0;
+	double cacheMissesPerParticle = 0.0;
+};
+
+struct LocalityResult
+{
+	std::string curve;
+	int particles = 0;
+	double linesPerRow = 0.0;
+	float memoryDisorder = 0.f;
+};
+
+static std::unique_ptr<CacheMissCounter> cacheMissCounter;
+
+static void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+		<< "  --sizes <n,n,...>         fluid particle counts (default 1000,10000,100000,1000000)\n"
+		<< "  --curves <name,name,...>  space filling curves, hash for the spatial hash search (default XYZ,ZIndex,HILBERT)\n"
+		<< "  --cell-lookup <name,...>  stencil cell lookup: linear, hashed, ranges (default hashed)\n"
+		<< "  --repetitions <n>         timed runs per kernel (default 10)\n"
+		<< "  --pair-cache <on|off>     cache kernel values and gradients per pair (default on)\n"
+		<< "  --reorder <k>             reorder particle memory along the curve every k searches, 0 never (default 1)\n"
+		<< "  --symmetric <on|off>      half-stencil search with mirrored pairs (default off)\n"
+		<< "  --list-free <on|off>      walk the cell stencils instead of storing neighbor lists (default off)\n";
+}
+
+static std::vector<std::string> splitList(const std::string &list)
+{
+	std::vector<std::string> items;
+	std::stringstream stream(list);
+	std::string item;
+
+	while (std::getline(stream, item, ',')) if (!item.empty()) items.push_back(item);
+
+	return items;
+}
+
+//Reads an on/off switch, anything else is rejected instead of silently meaning off
+static bool parseSwitch(const std::string &argument, const std::string &value, bool &flag)
+{
+	if (value == "on") flag = true;
+	else if (value == "off") flag = false;
+	else {
+		std::cerr << "Expected on or off for " << argument << ", got " << value << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+static bool parseArguments(int argc, char **argv, BenchmarkOptions &options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "--help" || argument == "-h" || i + 1 >= argc) return false;
+
+		std::string value = argv[++i];
+		bool valid = true;
+
+		if (argument == "--sizes") {
+			options.sizes.clear();
+			for (auto &size : splitList(value)) options.sizes.push_back(std::atoi(size.c_str()));
+		}
+		else if (argument == "--curves") options.curves = splitList(value);
+		else if (argument == "--cell-lookup") options.cellLookups = splitList(value);
+		else if (argument == "--pair-cache") valid = parseSwitch(argument, value, options.pairCache);
+		else if (argument == "--list-free") valid = parseSwitch(argument, value, options.listFree);
+		else if (argument == "--symmetric") valid = parseSwitch(argument, value, options.symmetric);
+		else if (argument == "--reorder") options.reorderInterval = std::atoi(value.c_str());
+		else if (argument == "--repetitions") options.repetitions = std::max(1, std::atoi(value.c_str()));
+		else return false;
+
+		if (!valid) return false;
+	}
+
+	return true;
+}
+
+//Square fluid column resting on the floor of a tank twice as wide, the usual dam break setup
+static void buildDamBreak(Solver &solver, int fluidParticles)
+{
+	float spacing = Solver::PARTICLE_SPACING;
+	int columns = (int)std::ceil(std::sqrt((float)fluidParticles));
+	int rows = (fluidParticles + columns - 1) / columns;
+
+	float minX = solver.centerPosition.x - Solver::radius;
+	float floorY = solver.centerPosition.y + Solver::radius;
+	float tankWidth = 2.f * columns * spacing;
+	float tankHeight = (rows + 2) * spacing;
+
+	for (float x = minX; x <= minX + tankWidth; x += spacing / 2)
+	{
+		solver.addParticle(x, floorY, true, up::Color::Red);
+	}
+
+	for (float y = floorY - spacing / 2; y >= floorY - tankHeight; y -= spacing / 2)
+	{
+		solver.addParticle(minX, y, true, up::Color::Red);
+		solver.addParticle(minX + tankWidth, y, true, up::Color::Red);
+	}
+
+	for (int i = 0; i < fluidParticles; i++)
+	{
+		float x = minX + spacing * (1 + i % columns);
+		float y = floorY - spacing * (1 + i / columns);
+
+		solver.addParticle(x, y, false, up::Color::Blue);
+	}
+}
+
+static BenchmarkResult measure(int repetitions, int particles, const std::function<void()> &kernel)
+{
+	std::vector<double> nsPerParticle;
+	uint64_t cacheMisses = 0;
+	up::Clock clock;
+
+	for (int i = 0; i < repetitions; i++)
+	{
+		cacheMissCounter->start();
+		clock.restart();
+		kernel();
+		nsPerParticle.push_back(clock.elapsedSeconds() * 1e9 / particles);
+		cacheMisses += cacheMissCounter->stop();
+	}
+
+	BenchmarkResult result;
+
+	result.cacheMissesPerParticle = (double)cacheMisses / ((double)repetitions * particles);
+
+	for (double sample : nsPerParticle) result.meanNsPerParticle += sample;
+	result.meanNsPerParticle /= repetitions;
+
+	for (double sample : nsPerParticle) result.varianceNsPerParticle += (sample - result.meanNsPerParticle) * (sample - result.meanNsPerParticle);
+	result.varianceNsPerParticle /= repetitions;
+
+	result.particlesPerSecond = result.meanNsPerParticle > 0.0 ? 1e9 / result.meanNsPerParticle : 0.0;
+
+	return result;
+}
+
+static void report(const std::string &curve, int particles, const std::string &kernel, const BenchmarkResult &result)
+{
+	std::cout << std::left << std::setw(9) << curve
+		<< std::right << std::setw(10) << particles
+		<< "  " << std::left << std::setw(23) << kernel
+		<< std::right << std::fixed << std::setprecision(2)
+		<< std::setw(14) << result.meanNsPerParticle
+		<< std::setw(16) << std::setprecision(0) << result.particlesPerSecond
+		<< std::setw(16) << std::setprecision(3) << result.varianceNsPerParticle;
+
+	if (cacheMissCounter->available()) std::cout << std::setw(16) << result.cacheMissesPerParticle << std::endl;
+	else std::cout << std::setw(16) << "-" << std::endl;
+}
+
+//Distinct 64 byte lines of the position array read per fluid neighbor row.
+//A software stand-in for cache misses that does not depend on hardware counters.
+static LocalityResult measureLocality(const std::string &curve, int particles, const Solver &solver)
+{
+	const NeighborList &list = solver.neighbors;
+	constexpr size_t POSITIONS_PER_LINE = 64 / sizeof(up::Vec2);
+
+	std::vector<size_t> lines;
+	size_t totalLines = 0;
+	size_t rows = 0;
+
+	for (size_t i = 0; i < list.numParticles(); i++)
+	{
+		if (solver.particles.isBoundary[i]) continue;
+
+		lines.clear();
+		list.forEachNeighbor(i, solver.particles, [&](uint32_t j) { lines.push_back(j / POSITIONS_PER_LINE); });
+
+		std::sort(lines.begin(), lines.end());
+		totalLines += std::unique(lines.begin(), lines.end()) - lines.begin();
+		rows++;
+	}
+
+	auto neighborSearch = std::dynamic_pointer_cast<NeighborSearch>(solver.solvers.at(0));
+
+	LocalityResult result;
+	result.curve = curve;
+	result.particles = particles;
+	result.linesPerRow = rows > 0 ? (double)totalLines / rows : 0.0;
+	//The spatial hash search leaves memory in insertion order, visiting it in bucket order
+	result.memoryDisorder = neighborSearch ? neighborSearch->memoryDisorder() : 1.f;
+
+	return result;
+}
+
+//Times the hot solver stages one at a time on synthetic dam break scenes.
+//Timings are normalized by the number of fluid particles.
+int main(int argc, char **argv)
+{
+	BenchmarkOptions options;
+
+	if (!parseArguments(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	NeighborSearch::CellLookup cellLookup;
+
+	for (auto &lookup : options.cellLookups)
+	{
+		if (!NeighborSearch::parseCellLookup(lookup, cellLookup)) {
+			std::cerr << "Unknown cell lookup " << lookup << std::endl;
+			return 1;
+		}
+	}
+
+	//Created before any parallel loop so the worker threads inherit the counter
+	cacheMissCounter = std::make_unique<CacheMissCounter>();
+
+	if (!cacheMissCounter->available()) std::cout << "Hardware cache counters unavailable, misses/particle is not reported" << std::endl;
+
+	std::cout << std::left << std::setw(9) << "curve"
+		<< std::right << std::setw(10) << "particles"
+		<< "  " << std::left << std::setw(23) << "kernel"
+		<< std::right << std::setw(14) << "ns/particle"
+		<< std::setw(16) << "particles/s"
+		<< std::setw(16) << "variance"
+		<< std::setw(16) << "misses/particle" << std::endl;
+
+	std::vector<LocalityResult> locality;
+
+	for (auto &curve : options.curves)
+	{
+		for (int size : options.sizes)
+		{
+			Solver solver("");
+			if (curve == "hash") solver.setNeighborSearchBackend("hash");
+			else if (!solver.setSpaceFillingCurve(curve)) {
+				std::cerr << "Unknown space filling curve " << curve << std::endl;
+				return 1;
+			}
+			solver.usePairCache = options.pairCache;
+			buildDamBreak(solver, size);
+
+			auto pressureSolver = std::dynamic_pointer_cast<PressureSolver>(solver.solvers.at(1));
+
+			//Every stage runs on the state left by the previous one, as in Solver::update()
+			auto neighborSearch = std::dynamic_pointer_cast<NeighborSearch>(solver.solvers.at(0));
+
+			if (!neighborSearch) report(curve, size, "neighbor search", measure(options.repetitions, size, [&]() { solver.solvers.at(0)->compute(); }));
+			else {
+				neighborSearch->reorderInterval = options.reorderInterval;
+				neighborSearch->symmetric = options.symmetric;
+				neighborSearch->listFree = options.listFree;
+			}
+
+			//The last lookup stays active for the remaining stages
+			for (auto &lookup : options.cellLookups)
+			{
+				if (!neighborSearch) break;
+
+				NeighborSearch::parseCellLookup(lookup, neighborSearch->cellLookup);
+
+				report(curve, size, "neighbor search/" + lookup, measure(options.repetitions, size, [&]() { neighborSearch->compute(); }));
+			}
+
+			locality.push_back(measureLocality(curve, size, solver));
+
+			//The list-free mode stores no pairs to cache
+			if (options.pairCache && !options.listFree) report(curve, size, "pair cache", measure(options.repetitions, size, [&]() { solver.computePairCache(); }));
+			else solver.computePairCache();
+
+			report(curve, size, "density", measure(options.repetitions, size, [&]() { solver.computeDensity(); }));
+
+			solver.computeNonPressureForces();
+			pressureSolver->initialize();
+
+			//Everything between the pair cache and the first pressure iteration, as separate loops and fused
+			report(curve, size, "init", measure(options.repetitions, size, [&]()
+				{
+					solver.computeDensity();
+					solver.computeNonPressureForces();
+					pressureSolver->initialize();
+				}));
+
+			pressureSolver->fusedInitialization = true;
+			report(curve, size, "init/fused", measure(options.repetitions, size, [&]()
+				{
+					solver.computeFusedInit();
+					pressureSolver->initialize();
+				}));
+			pressureSolver->fusedInitialization = false;
+
+			report(curve, size, "pressure acceleration", measure(options.repetitions, size, [&]() { pressureSolver->computePressureAccelerations(solver.particles.pressure); }));
+			report(curve, size, "pressure iteration", measure(options.repetitions, size, [&]() { pressureSolver->iterate(); }));
+
+			solver.applyPressureForce();
+
+			report(curve, size, "update positions", measure(options.repetitions, size, [&]() { solver.updatePositions(); }));
+		}
+	}
+
+	//How well each curve keeps spatial neighbors close in memory
+	std::cout << std::endl
+		<< std::left << std::setw(9) << "curve"
+		<< std::right << std::setw(10) << "particles"
+		<< std::setw(16) << "lines/row"
+		<< std::setw(16) << "disorder" << std::endl;
+
+	for (auto &result : locality)
+	{
+		std::cout << std::left << std::setw(9) << result.curve
+			<< std::right << std::setw(10) << result.particles
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(16) << result.linesPerRow
+			<< std::setw(16) << std::setprecision(3) << result.memoryDisorder << std::endl;
+	}
+
+	return 0;
+}
@@ -0,0 +1,298 @@
+#include "solvers/solver.hpp"
+#include "scenes/sceneLoader.hpp"
+#include "helpers/clock.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+struct HeadlessOptions
+{
+	std::string scene = "dambreak";
+	std::string curve = "ZIndex";
+	std::string neighborSearch = "grid";
+	std::string logPath = "simulation_data.csv";
+	std::string outputPath = "final_state.csv";
+	int fluidParticles = 10000;
+	int steps = 100;
+	bool pairCache = true;
+	int reorderInterval = 1;
+	float reorderThreshold = 0.f;
+	float skin = 0.f;
+	bool symmetric = false;
+	std::string cellLookup = "hashed";
+	bool listFree = false;
+	std::string pressureSolver = "jacobi";
+	std::string warmStart = "off";
+	bool fusedInit = false;
+	bool activeSet = false;
+	float dt = 0.01f;
+	float stiffness = 0.f;
+};
+
+static void printUsage(const char *program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+		<< "  --scene <name|file>     built-in scene (dambreak) or scene file (default dambreak)\n"
+		<< "  --curve <name>          space filling curve: XYZ, ZIndex or HILBERT (default ZIndex)\n"
+		<< "  --neighbor-search <name> grid (cells sorted along the curve) or hash (unbounded scenes) (default grid)\n"
+		<< "  --particles <n>         fluid particles for built-in scenes (default 10000)\n"
+		<< "  --pair-cache <on|off>   cache kernel values and gradients per neighbor pair (default on)\n"
+		<< "  --reorder-interval <k>  reorder particle memory along the curve every k steps, 0 never (default 1)\n"
+		<< "  --reorder-threshold <x> also reorder once the memory order disorder exceeds x, 0 never (default 0)\n"
+		<< "  --skin <s>              Verlet list skin, lists are rebuilt only after moves beyond s / 2 (default 0, off)\n"
+		<< "  --cell-lookup <name>    stencil cell lookup: linear, hashed or ranges (default hashed)\n"
+		<< "  --list-free <on|off>    walk the cell stencils in every loop instead of storing neighbor lists (default off)\n"
+		<< "  --symmetric <on|off>    half-stencil search, every pair is found once and mirrored (default off)\n"
+		<< "  --pressure-solver <name> jacobi (relaxed Jacobi), cg (preconditioned BiCGSTAB)\n"
+		<< "                          wcsph (explicit state equation, for previews) or dfsph (divergence-free SPH) (default jacobi)\n"
+		<< "  --stiffness <k>         state equation stiffness of the wcsph solver (default 100000)\n"
+		<< "  --warm-start <mode>     start the pressure solve from off (zero), on (previous pressure) or scaled (by dt ratio) (default off)\n"
+		<< "  --active-set <on|off>   jacobi iterations between full ones only sweep particles above tolerance and their neighbors (default off)\n"
+		<< "  --fused-init <on|off>   compute density, forces, source term and diagonal in two neighbor sweeps (default off)\n"
+		<< "  --dt <s>                time step (default 0.01)\n"
+		<< "  --steps <n>             simulation steps to run (default 100)\n"
+		<< "  --log <file>            per-step timing log (default simulation_data.csv)\n"
+		<< "  --output <file>         final particle state (default final_state.csv)\n";
+}
+
+//Reads an on/off switch, anything else is rejected instead of silently meaning off
+static bool parseSwitch(const std::string &argument, const std::string &value, bool &flag)
+{
+	if (value == "on") flag = true;
+	else if (value == "off") flag = false;
+	else {
+		std::cerr << "Expected on or off for " << argument << ", got " << value << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+static bool parseArguments(int argc, char **argv, HeadlessOptions &options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		std::string argument = argv[i];
+
+		if (argument == "--help" || argument == "-h") return false;
+
+		if (i + 1 >= argc) {
+			std::cerr << "Missing value for " << argument << std::endl;
+			return false;
+		}
+
+		std::string value = argv[++i];
+		bool valid = true;
+
+		if (argument == "--scene") options.scene = value;
+		else if (argument == "--curve") options.curve = value;
+		else if (argument == "--neighbor-search") options.neighborSearch = value;
+		else if (argument == "--particles") options.fluidParticles = std::atoi(value.c_str());
+		else if (argument == "--pair-cache") valid = parseSwitch(argument, value, options.pairCache);
+		else if (argument == "--reorder-interval") options.reorderInterval = std::atoi(value.c_str());
+		else if (argument == "--reorder-threshold") options.reorderThreshold = (float)std::atof(value.c_str());
+		else if (argument == "--skin") options.skin = (float)std::atof(value.c_str());
+		else if (argument == "--cell-lookup") options.cellLookup = value;
+		else if (argument == "--list-free") valid = parseSwitch(argument, value, options.listFree);
+		else if (argument == "--symmetric") valid = parseSwitch(argument, value, options.symmetric);
+		else if (argument == "--pressure-solver") options.pressureSolver = value;
+		else if (argument == "--warm-start") options.warmStart = value;
+		else if (argument == "--active-set") valid = parseSwitch(argument, value, options.activeSet);
+		else if (argument == "--fused-init") valid = parseSwitch(argument, value, options.fusedInit);
+		else if (argument == "--stiffness") options.stiffness = (float)std::atof(value.c_str());
+		else if (argument == "--dt") options.dt = (float)std::atof(value.c_str());
+		else if (argument == "--steps") options.steps = std::atoi(value.c_str());
+		else if (argument == "--log") options.logPath = value;
+		else if (argument == "--output") options.outputPath = value;
+		else {
+			std::cerr << "Unknown option " << argument << std::endl;
+			return false;
+		}
+
+		if (!valid) return false;
+	}
+
+	return true;
+}
+
+static bool writeFinalState(const Solver &solver, const std::string &path)
+{
+	std::ofstream stateFile(path);
+
+	if (!stateFile.is_open()) return false;
+
+	stateFile << "x,y,vx,vy,density,pressure,isBoundary" << std::endl;
+
+	const ParticleStore &ps = solver.particles;
+
+	for (size_t i = 0; i < ps.size(); i++)
+	{
+		stateFile << ps.position[i].x << "," << ps.position[i].y << ","
+			<< ps.velocity[i].x << "," << ps.velocity[i].y << ","
+			<< ps.density[i] << "," << ps.pressure[i] << "," << (int)ps.isBoundary[i] << "\n";
+	}
+
+	return true;
+}
+
+//Runs a scene without a window or frame cap, for batch runs on display-less machines
+int main(int argc, char **argv)
+{
+	HeadlessOptions options;
+
+	if (!parseArguments(argc, argv, options)) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	Solver solver(options.logPath);
+	solver.usePairCache = options.pairCache;
+
+	if (!solver.setNeighborSearchBackend(options.neighborSearch)) {
+		std::cerr << "Unknown neighbor search " << options.neighborSearch << std::endl;
+		return 1;
+	}
+
+	if (!solver.setPressureSolver(options.pressureSolver)) {
+		std::cerr << "Unknown pressure solver " << options.pressureSolver << std::endl;
+		return 1;
+	}
+
+	solver.useFusedInit = options.fusedInit;
+	solver.dt = options.dt;
+	if (options.stiffness > 0.f) solver.STIFFNESS = options.stiffness;
+
+	auto pressureSolver = std::dynamic_pointer_cast<PressureSolver>(solver.solvers.at(1));
+	auto divergenceFreeSolver = std::dynamic_pointer_cast<DivergenceFreeSolver>(solver.solvers.at(1));
+
+	auto conjugateGradientSolver = std::dynamic_pointer_cast<ConjugateGradientSolver>(solver.solvers.at(1));
+
+	//Only the iterative solvers start from a pressure guess and read source term and diagonal
+	bool isIterative = options.pressureSolver == "jacobi" || options.pressureSolver == "cg";
+
+	if (options.warmStart != "off" && !isIterative) {
+		std::cerr << "Warm start needs the jacobi or cg pressure solver" << std::endl;
+		return 1;
+	}
+
+	if (options.fusedInit && !isIterative) {
+		std::cerr << "The fused init needs the jacobi or cg pressure solver" << std::endl;
+		return 1;
+	}
+
+	if (options.activeSet) {
+		if (options.pressureSolver != "jacobi") {
+			std::cerr << "The active set needs the jacobi pressure solver" << std::endl;
+			return 1;
+		}
+
+		pressureSolver->activeSet = true;
+	}
+
+	if (options.warmStart == "on") pressureSolver->warmStart = PressureSolver::WarmStart::Previous;
+	else if (options.warmStart == "scaled") pressureSolver->warmStart = PressureSolver::WarmStart::DtScaled;
+	else if (options.warmStart != "off") {
+		std::cerr << "Unknown warm start mode " << options.warmStart << std::endl;
+		return 1;
+	}
+
+	NeighborSearch::CellLookup cellLookup;
+
+	if (!NeighborSearch::parseCellLookup(options.cellLookup, cellLookup)) {
+		std::cerr << "Unknown cell lookup " << options.cellLookup << std::endl;
+		return 1;
+	}
+
+	//The hash search builds plain full lists every step, it has no skin, half lists or list-free mode
+	if (options.neighborSearch == "hash" && (options.skin > 0.f || options.symmetric || options.listFree)) {
+		std::cerr << "--skin, --symmetric and --list-free need the grid neighbor search" << std::endl;
+		return 1;
+	}
+
+	//Curve, reordering and Verlet lists only apply to the grid search
+	if (options.neighborSearch == "grid" && !solver.setSpaceFillingCurve(options.curve)) {
+		std::cerr << "Unknown space filling curve " << options.curve << std::endl;
+		return 1;
+	}
+
+	auto neighborSearch = std::dynamic_pointer_cast<NeighborSearch>(solver.solvers.at(0));
+
+	if (neighborSearch) {
+		neighborSearch->reorderInterval = options.reorderInterval;
+		neighborSearch->reorderThreshold = options.reorderThreshold;
+		neighborSearch->skin = options.skin;
+		neighborSearch->symmetric = options.symmetric;
+		neighborSearch->listFree = options.listFree;
+
+		neighborSearch->cellLookup = cellLookup;
+	}
+
+	SceneLoader loader(solver);
+
+	if (!loader.load(options.scene, options.fluidParticles)) {
+		std::cerr << "Failed to load scene: " << loader.getError() << std::endl;
+		return 1;
+	}
+
+	std::cout << "Scene: " << options.scene << " (" << solver.numFluidParticles << " fluid, "
+		<< solver.particles.size() << " total particles)" << std::endl;
+
+	solver.updating = true;
+
+	up::Clock runClock;
+	long long pressureIterations = 0;
+	long long divergenceIterations = 0;
+	long long fallbackIterations = 0;
+	int fallbackSteps = 0;
+
+	for (int step = 0; step < options.steps; step++)
+	{
+		solver.update();
+		pressureIterations += solver.solvers.at(1)->numIterations;
+		if (divergenceFreeSolver) divergenceIterations += divergenceFreeSolver->numDivergenceIterations;
+
+		if (conjugateGradientSolver && conjugateGradientSolver->numFallbackIterations > 0) {
+			fallbackIterations += conjugateGradientSolver->numFallbackIterations;
+			fallbackSteps++;
+		}
+
+		//No frame is presented, keep the render time column for a consistent log
+		solver.finishDataRow(0);
+	}
+
+	double elapsed = runClock.elapsedSeconds();
+
+	solver.closeFile();
+
+	if (!writeFinalState(solver, options.outputPath)) {
+		std::cerr << "Could not write final state to " << options.outputPath << std::endl;
+		return 1;
+	}
+
+	double stepsPerSecond = elapsed > 0.0 ? options.steps / elapsed : 0.0;
+
+	std::cout << "Steps: " << options.steps << "\n"
+		<< "Total time: " << elapsed << " s\n"
+		<< "Average step: " << (options.steps > 0 ? 1000.0 * elapsed / options.steps : 0.0) << " ms\n"
+		<< "Steps/s: " << stepsPerSecond << "\n"
+		<< "Particle updates/s: " << stepsPerSecond * solver.particles.size() << "\n"
+		<< "Pressure iterations: " << pressureIterations << " (" << (options.steps > 0 ? (double)pressureIterations / options.steps : 0.0) << " per step)\n"
+		<< "Neighbor data: " << solver.neighbors.memoryBytes() / 1024 << " KiB" << std::endl;
+
+	if (divergenceFreeSolver) {
+		std::cout << "Divergence iterations: " << divergenceIterations << " (" << (options.steps > 0 ? (double)divergenceIterations / options.steps : 0.0) << " per step)" << std::endl;
+	}
+
+	if (conjugateGradientSolver) {
+		std::cout << "CG not converged: " << fallbackSteps << " steps, finished with " << fallbackIterations << " Jacobi iterations" << std::endl;
+	}
+
+	if (neighborSearch) {
+		std::cout << "Neighbor list builds: " << neighborSearch->numRebuilds() << "\n"
+			<< "Memory reorders: " << neighborSearch->numReorders() << std::endl;
+	}
+
+	return 0;
+}
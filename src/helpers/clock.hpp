@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+
+namespace up
+{
+
+	//Minimal stopwatch replacing sf::Clock in the simulation core
+	class Clock
+	{
+	public:
+		Clock() noexcept :
+			start(std::chrono::steady_clock::now())
+		{}
+
+		void restart()
+		{
+			start = std::chrono::steady_clock::now();
+		}
+
+		long long elapsedMilliseconds() const
+		{
+			return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		double elapsedSeconds() const
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+	private:
+		std::chrono::steady_clock::time_point start;
+	};
+
+}
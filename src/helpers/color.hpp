@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace up
+{
+
+	//Plain RGBA color so the simulation core does not depend on SFML
+	struct Color
+	{
+		uint8_t r = 0;
+		uint8_t g = 0;
+		uint8_t b = 0;
+		uint8_t a = 255;
+
+		static const Color Red;
+		static const Color Green;
+		static const Color Blue;
+		static const Color Magenta;
+	};
+
+	inline const Color Color::Red = { 255, 0, 0, 255 };
+	inline const Color Color::Green = { 0, 255, 0, 255 };
+	inline const Color Color::Blue = { 0, 0, 255, 255 };
+	inline const Color Color::Magenta = { 255, 0, 255, 255 };
+
+}
@@ -1,6 +1,11 @@
 #pragma once
+
+#include <cstddef>
+#include <cstdint>
+
 struct CompactCell
 {
+	//Position of the cell's first particle in the sorted order
 	size_t particle;
-	int cell;
+	uint64_t cell;
 };
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "helpers/parallel.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+//Open addressing hash table from cell key to compact cell index.
+//Insertions are lock free so the table can be filled from a parallel loop, lookups are O(1) on average.
+class CompactHashTable
+{
+public:
+	static constexpr uint64_t EMPTY_KEY = ~(uint64_t)0;
+
+	//Clears the table and sizes it for numKeys insertions at a load factor of at most one half
+	void reset(size_t numKeys)
+	{
+		size_t requiredCapacity = 16;
+		while (requiredCapacity < 2 * numKeys) requiredCapacity *= 2;
+
+		if (requiredCapacity != capacity) {
+			capacity = requiredCapacity;
+			keys.reset(new std::atomic<uint64_t>[capacity]);
+			values.reset(new uint32_t[capacity]);
+		}
+
+		up::parallelFor(capacity, [this](size_t slot) { keys[slot].store(EMPTY_KEY, std::memory_order_relaxed); });
+	}
+
+	//Thread safe as long as every key is inserted only once
+	void insert(uint64_t key, uint32_t value)
+	{
+		size_t slot = hash(key);
+
+		while (true)
+		{
+			uint64_t expected = EMPTY_KEY;
+
+			if (keys[slot].compare_exchange_strong(expected, key, std::memory_order_relaxed)) {
+				values[slot] = value;
+				return;
+			}
+
+			slot = (slot + 1) & (capacity - 1);
+		}
+	}
+
+	//Must not run concurrently with insert
+	bool find(uint64_t key, uint32_t &value) const
+	{
+		if (key == EMPTY_KEY || capacity == 0) return false;
+
+		size_t slot = hash(key);
+
+		while (true)
+		{
+			uint64_t storedKey = keys[slot].load(std::memory_order_relaxed);
+
+			if (storedKey == key) {
+				value = values[slot];
+				return true;
+			}
+			if (storedKey == EMPTY_KEY) return false;
+
+			slot = (slot + 1) & (capacity - 1);
+		}
+	}
+
+private:
+	size_t capacity = 0;
+	std::unique_ptr<std::atomic<uint64_t>[]> keys;
+	std::unique_ptr<uint32_t[]> values;
+
+	//Fibonacci hashing spreads the consecutive keys of neighboring cells over the table
+	size_t hash(uint64_t key) const
+	{
+		return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (capacity - 1);
+	}
+};
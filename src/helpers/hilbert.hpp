@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+//Hilbert curve keys of 2D cell coordinates, with 32 bit keys (16 bits per axis) or 64 bit keys (32 bits per axis).
+//The curve is walked from the most significant level down. The orientation of the remaining sub-square is one of
+//four states (swap the axes, mirror both axes), and lookup tables advance it four levels at a time.
+namespace up::hilbert
+{
+	namespace detail
+	{
+		//Quadrant and next state for one level, same orientation convention as the classic xy2d/d2xy
+		constexpr void step(unsigned &state, unsigned rx, unsigned ry)
+		{
+			if (ry == 0) state ^= 1u | (rx << 1);
+		}
+
+		//Entry [state << 8 | xNibble << 4 | yNibble]: key byte in the low 8 bits, next state above
+		constexpr std::array<uint16_t, 1024> makeEncodeTable()
+		{
+			std::array<uint16_t, 1024> table{};
+
+			for (unsigned entry = 0; entry < 1024; entry++)
+			{
+				unsigned state = entry >> 8;
+				unsigned x = (entry >> 4) & 15u;
+				unsigned y = entry & 15u;
+				unsigned key = 0;
+
+				for (int bit = 3; bit >= 0; bit--)
+				{
+					unsigned xBit = (x >> bit) & 1u;
+					unsigned yBit = (y >> bit) & 1u;
+					unsigned swap = state & 1u;
+					unsigned mirror = (state >> 1) & 1u;
+
+					unsigned rx = (swap ? yBit : xBit) ^ mirror;
+					unsigned ry = (swap ? xBit : yBit) ^ mirror;
+
+					key = (key << 2) | ((3u * rx) ^ ry);
+					step(state, rx, ry);
+				}
+
+				table[entry] = (uint16_t)(key | (state << 8));
+			}
+
+			return table;
+		}
+
+		//Entry [state << 8 | keyByte]: x nibble in bits 0-3, y nibble in bits 4-7, next state above
+		constexpr std::array<uint16_t, 1024> makeDecodeTable()
+		{
+			std::array<uint16_t, 1024> table{};
+
+			for (unsigned entry = 0; entry < 1024; entry++)
+			{
+				unsigned state = entry >> 8;
+				unsigned key = entry & 255u;
+				unsigned x = 0;
+				unsigned y = 0;
+
+				for (int level = 3; level >= 0; level--)
+				{
+					unsigned quadrant = (key >> (2 * level)) & 3u;
+					unsigned rx = quadrant >> 1;
+					unsigned ry = (quadrant ^ rx) & 1u;
+					unsigned swap = state & 1u;
+					unsigned mirror = (state >> 1) & 1u;
+
+					unsigned a = rx ^ mirror;
+					unsigned b = ry ^ mirror;
+
+					x = (x << 1) | (swap ? b : a);
+					y = (y << 1) | (swap ? a : b);
+					step(state, rx, ry);
+				}
+
+				table[entry] = (uint16_t)(x | (y << 4) | (state << 8));
+			}
+
+			return table;
+		}
+
+		inline constexpr std::array<uint16_t, 1024> ENCODE_TABLE = makeEncodeTable();
+		inline constexpr std::array<uint16_t, 1024> DECODE_TABLE = makeDecodeTable();
+	}
+
+	template <typename Key>
+	inline Key encode(uint32_t x, uint32_t y)
+	{
+		constexpr int BITS_PER_AXIS = (int)sizeof(Key) * 4;
+
+		Key key = 0;
+		unsigned state = 0;
+
+		for (int shift = BITS_PER_AXIS - 4; shift >= 0; shift -= 4)
+		{
+			unsigned entry = (state << 8) | (((x >> shift) & 15u) << 4) | ((y >> shift) & 15u);
+			uint16_t value = detail::ENCODE_TABLE[entry];
+
+			key = (Key)((key << 8) | (value & 255u));
+			state = value >> 8;
+		}
+
+		return key;
+	}
+
+	template <typename Key>
+	inline void decode(Key key, uint32_t &x, uint32_t &y)
+	{
+		constexpr int BITS_PER_AXIS = (int)sizeof(Key) * 4;
+
+		unsigned state = 0;
+		x = 0;
+		y = 0;
+
+		for (int shift = BITS_PER_AXIS - 4; shift >= 0; shift -= 4)
+		{
+			unsigned entry = (state << 8) | (unsigned)((key >> (2 * shift)) & 255u);
+			uint16_t value = detail::DECODE_TABLE[entry];
+
+			x = (x << 4) | (value & 15u);
+			y = (y << 4) | ((value >> 4) & 15u);
+			state = value >> 8;
+		}
+	}
+}
@@ -1,7 +0,0 @@
-#pragma once
-#include "vector2.hpp"
-
-up::Vec2 d2xy(int n, int d);
-int i4_power(int i, int j);
-void rot(int n, int &x, int &y, int rx, int ry);
-int xy2d(int n, int x, int y);
\ No newline at end of file
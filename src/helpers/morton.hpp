@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define UP_MORTON_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//64 bit Morton (Z order) keys of 2D cell coordinates, 32 bits per axis.
+//Bit i of x lands on bit 2i of the key and bit i of y on bit 2i + 1.
+//Uses the BMI2 bit deposit/extract instructions when the CPU has them and magic bit shifts otherwise.
+namespace up::morton
+{
+	static constexpr uint64_t EVEN_BITS = 0x5555555555555555ull;
+	static constexpr uint64_t ODD_BITS = 0xAAAAAAAAAAAAAAAAull;
+
+	//Spreads the 32 bits of value over the even bits of the result
+	inline uint64_t spreadBits(uint32_t value)
+	{
+		uint64_t bits = value;
+		bits = (bits | (bits << 16)) & 0x0000FFFF0000FFFFull;
+		bits = (bits | (bits << 8)) & 0x00FF00FF00FF00FFull;
+		bits = (bits | (bits << 4)) & 0x0F0F0F0F0F0F0F0Full;
+		bits = (bits | (bits << 2)) & 0x3333333333333333ull;
+		bits = (bits | (bits << 1)) & 0x5555555555555555ull;
+		return bits;
+	}
+
+	//Gathers the even bits of bits into the lower 32 bits of the result
+	inline uint32_t compactBits(uint64_t bits)
+	{
+		bits &= 0x5555555555555555ull;
+		bits = (bits | (bits >> 1)) & 0x3333333333333333ull;
+		bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFull;
+		bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFull;
+		bits = (bits | (bits >> 16)) & 0x00000000FFFFFFFFull;
+		return (uint32_t)bits;
+	}
+
+	inline uint64_t encodeMagicBits(uint32_t x, uint32_t y)
+	{
+		return spreadBits(x) | (spreadBits(y) << 1);
+	}
+
+	inline void decodeMagicBits(uint64_t key, uint32_t &x, uint32_t &y)
+	{
+		x = compactBits(key);
+		y = compactBits(key >> 1);
+	}
+
+#ifdef UP_MORTON_X86
+#ifndef _MSC_VER
+	__attribute__((target("bmi2")))
+#endif
+	inline uint64_t encodeBmi2(uint32_t x, uint32_t y)
+	{
+		return _pdep_u64(x, EVEN_BITS) | _pdep_u64(y, ODD_BITS);
+	}
+
+#ifndef _MSC_VER
+	__attribute__((target("bmi2")))
+#endif
+	inline void decodeBmi2(uint64_t key, uint32_t &x, uint32_t &y)
+	{
+		x = (uint32_t)_pext_u64(key, EVEN_BITS);
+		y = (uint32_t)_pext_u64(key, ODD_BITS);
+	}
+
+	inline bool detectBmi2()
+	{
+#ifdef _MSC_VER
+		int registers[4];
+		__cpuidex(registers, 7, 0);
+		return (registers[1] & (1 << 8)) != 0;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("bmi2");
+#endif
+	}
+
+	//Checked once, the branch on it is always predicted
+	inline const bool hasBmi2 = detectBmi2();
+#else
+	inline const bool hasBmi2 = false;
+#endif
+
+	inline uint64_t encode(uint32_t x, uint32_t y)
+	{
+#ifdef UP_MORTON_X86
+		if (hasBmi2) return encodeBmi2(x, y);
+#endif
+		return encodeMagicBits(x, y);
+	}
+
+	inline void decode(uint64_t key, uint32_t &x, uint32_t &y)
+	{
+#ifdef UP_MORTON_X86
+		if (hasBmi2) {
+			decodeBmi2(key, x, y);
+			return;
+		}
+#endif
+		decodeMagicBits(key, x, y);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "helpers/neighborList.hpp"
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <vector>
+
+//Neighbor rows of the particles at positions [firstPosition, lastPosition) of a search's visiting order.
+//Chunks are gathered in parallel into their own buffers and merged into the list afterwards.
+struct NeighborChunk
+{
+	size_t firstPosition = 0;
+	size_t lastPosition = 0;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> boundaryScratch;
+
+	void clear()
+	{
+		indices.clear();
+	}
+
+	void beginRow()
+	{
+		rowStart = indices.size();
+		boundaryScratch.clear();
+	}
+
+	void add(uint32_t neighbor, bool isBoundary)
+	{
+		if (isBoundary) boundaryScratch.push_back(neighbor);
+		else indices.push_back(neighbor);
+	}
+
+	//Closes the row of particle k, fluid neighbors first. Records the fluid count in boundaryOffsets[k]
+	//and the row length in rowLengths[k], both are turned into offsets by mergeNeighborChunks.
+	void endRow(uint32_t k, NeighborList &list, std::vector<uint32_t> &rowLengths)
+	{
+		list.boundaryOffsets[k] = (uint32_t)(indices.size() - rowStart);
+		indices.insert(indices.end(), boundaryScratch.begin(), boundaryScratch.end());
+		rowLengths[k] = (uint32_t)(indices.size() - rowStart);
+	}
+
+private:
+	size_t rowStart = 0;
+};
+
+//Turns the row lengths into offsets and copies the rows of every chunk to the slots of their particles.
+//order maps visiting positions to particles, its identity makes every chunk a single consecutive block.
+inline void mergeNeighborChunks(std::vector<NeighborChunk> &chunks, const std::vector<uint32_t> &order,
+	const std::vector<uint32_t> &rowLengths, NeighborList &list)
+{
+	size_t numParticles = rowLengths.size();
+
+	list.offsets.resize(numParticles + 1);
+	list.offsets[0] = 0;
+	std::inclusive_scan(std::execution::par, rowLengths.begin(), rowLengths.end(), list.offsets.begin() + 1);
+
+	up::parallelFor(numParticles, [&list](size_t k) { list.boundaryOffsets[k] += list.offsets[k]; });
+
+	list.indices.resize(list.offsets[numParticles]);
+
+	std::for_each(
+		std::execution::par,
+		chunks.begin(),
+		chunks.end(),
+		[&order, &rowLengths, &list](const NeighborChunk &chunk)
+		{
+			auto row = chunk.indices.begin();
+
+			for (size_t position = chunk.firstPosition; position < chunk.lastPosition; position++)
+			{
+				uint32_t k = order[position];
+
+				std::copy(row, row + rowLengths[k], list.indices.begin() + list.offsets[k]);
+				row += rowLengths[k];
+			}
+		});
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "helpers/parallel.hpp"
+#include "helpers/vector2.hpp"
+#include "particles/particleStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Contiguous run of particle indices that can be walked with a range-based for loop
+struct IndexRange
+{
+	const uint32_t *first;
+	const uint32_t *last;
+
+	const uint32_t *begin() const { return first; }
+	const uint32_t *end() const { return last; }
+	size_t size() const { return last - first; }
+	bool empty() const { return first == last; }
+};
+
+//Range of pair positions in the neighbor list, the neighbor itself is indices[p]
+struct PairRange
+{
+	size_t first;
+	size_t last;
+
+	up::IndexIterator begin() const { return up::IndexIterator(first); }
+	up::IndexIterator end() const { return up::IndexIterator(last); }
+	size_t size() const { return last - first; }
+};
+
+//Half open range [first, last) of positions in the sorted order of a cell based neighbor search
+struct PositionRange
+{
+	uint32_t first;
+	uint32_t last;
+};
+
+//Neighbor lists of all particles in compressed sparse row layout.
+//The neighbors of particle i are indices[offsets[i], offsets[i + 1]): fluid neighbors come first,
+//boundary neighbors start at boundaryOffsets[i].
+struct NeighborList
+{
+	std::vector<uint32_t> offsets = { 0 };
+	std::vector<uint32_t> boundaryOffsets;
+	std::vector<uint32_t> indices;
+
+	//Optional per pair cache of the kernel value W_ij and kernel gradient grad W_ij,
+	//filled once per step after the neighbor search while positions stay fixed
+	bool hasPairCache = false;
+	std::vector<float> kernelValues;
+	std::vector<up::Vec2> kernelGradients;
+
+	//Verlet lists are built with a skin beyond the kernel support and reused for several steps,
+	//so their rows also hold pairs outside the support that every loop has to skip
+	bool hasSkin = false;
+	float support = 0.f;
+
+	bool inSupport(up::Vec2 distanceVector) const { return !hasSkin || distanceVector.length() < support; }
+
+	//Symmetric lists are built from pairs found once. Rows are sorted by neighbor index and mirror[p]
+	//is the position of the pair (j, i) for the pair p = (i, j), so per pair values can be shared.
+	bool isSymmetric = false;
+	std::vector<uint32_t> mirror;
+
+	//List-free mode: no rows are stored. Neighbors of particle i are found on the fly by walking the particle ranges
+	//of its cell's stencil in sorted order and testing distances against the support, see forEachFluid/forEachBoundary.
+	//The ranges of cell c are cellRanges[c * MAX_CELL_RANGES, c * MAX_CELL_RANGES + cellRangeCounts[c]).
+	static constexpr size_t MAX_CELL_RANGES = 9;
+	static constexpr size_t NO_PAIR = SIZE_MAX;
+
+	bool isCellPairs = false;
+	std::vector<uint32_t> particleCells;
+	std::vector<uint8_t> cellRangeCounts;
+	std::vector<PositionRange> cellRanges;
+	std::vector<uint32_t> sortedParticles;
+
+	//Releases the list-free data once rows are built again
+	void clearCellPairs()
+	{
+		isCellPairs = false;
+		particleCells = {};
+		cellRangeCounts = {};
+		cellRanges = {};
+		sortedParticles = {};
+	}
+
+	//Bytes held by rows, pair cache and list-free data
+	size_t memoryBytes() const
+	{
+		return (offsets.size() + boundaryOffsets.size() + indices.size() + mirror.size() + particleCells.size() + sortedParticles.size()) * sizeof(uint32_t)
+			+ kernelValues.size() * sizeof(float) + kernelGradients.size() * sizeof(up::Vec2)
+			+ cellRangeCounts.size() * sizeof(uint8_t) + cellRanges.size() * sizeof(PositionRange);
+	}
+
+	size_t numParticles() const { return isCellPairs ? particleCells.size() : boundaryOffsets.size(); }
+	size_t numPairs() const { return indices.size(); }
+
+	IndexRange fluid(size_t i) const
+	{
+		return { indices.data() + offsets[i], indices.data() + boundaryOffsets[i] };
+	}
+
+	IndexRange boundary(size_t i) const
+	{
+		return { indices.data() + boundaryOffsets[i], indices.data() + offsets[i + 1] };
+	}
+
+	IndexRange all(size_t i) const
+	{
+		return { indices.data() + offsets[i], indices.data() + offsets[i + 1] };
+	}
+
+	PairRange fluidPairs(size_t i) const
+	{
+		return { offsets[i], boundaryOffsets[i] };
+	}
+
+	PairRange boundaryPairs(size_t i) const
+	{
+		return { boundaryOffsets[i], offsets[i + 1] };
+	}
+
+	PairRange allPairs(size_t i) const
+	{
+		return { offsets[i], offsets[i + 1] };
+	}
+
+	//Calls f(p, j) for every fluid neighbor j of particle i. p is the pair position, NO_PAIR in the list-free mode.
+	template <typename F>
+	void forEachFluid(size_t i, const ParticleStore &ps, F &&f) const
+	{
+		if (!isCellPairs) {
+			for (size_t p : fluidPairs(i)) f(p, indices[p]);
+			return;
+		}
+
+		forEachCellPair(i, ps, false, f);
+	}
+
+	//Calls f(p, j) for every boundary neighbor j of particle i
+	template <typename F>
+	void forEachBoundary(size_t i, const ParticleStore &ps, F &&f) const
+	{
+		if (!isCellPairs) {
+			for (size_t p : boundaryPairs(i)) f(p, indices[p]);
+			return;
+		}
+
+		forEachCellPair(i, ps, true, f);
+	}
+
+	//Calls f(p, j) for every fluid pair of a symmetric list that particle i owns, the ones with j >= i.
+	//The owner computes an antisymmetric pair term once and writes it to p and mirror[p], so every slot has one writer.
+	template <typename F>
+	void forEachOwnedFluid(size_t i, F &&f) const
+	{
+		for (size_t p : fluidPairs(i))
+		{
+			if (indices[p] >= i) f(p, indices[p]);
+		}
+	}
+
+	//Calls f(j) for every neighbor j of particle i, fluid neighbors first
+	template <typename F>
+	void forEachNeighbor(size_t i, const ParticleStore &ps, F &&f) const
+	{
+		forEachFluid(i, ps, [&f](size_t, uint32_t j) { f(j); });
+		forEachBoundary(i, ps, [&f](size_t, uint32_t j) { f(j); });
+	}
+
+private:
+	//The type test comes first, so every candidate of the stencil is distance tested once per fluid and boundary pass
+	template <typename F>
+	void forEachCellPair(size_t i, const ParticleStore &ps, bool boundary, F &f) const
+	{
+		up::Vec2 position = ps.position[i];
+		size_t firstRange = particleCells[i] * MAX_CELL_RANGES;
+		size_t lastRange = firstRange + cellRangeCounts[particleCells[i]];
+
+		for (size_t r = firstRange; r < lastRange; r++)
+		{
+			for (uint32_t s = cellRanges[r].first; s < cellRanges[r].last; s++)
+			{
+				uint32_t j = sortedParticles[s];
+
+				if ((bool)ps.isBoundary[j] != boundary) continue;
+				if ((position - ps.position[j]).length() < support) f(NO_PAIR, j);
+			}
+		}
+	}
+};
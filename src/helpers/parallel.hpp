@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <vector>
+
+namespace up
+{
+
+	//Random access iterator over a range of integers, lets the parallel algorithms walk particle indices
+	class IndexIterator
+	{
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = size_t;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const size_t*;
+		using reference = const size_t&;
+
+		IndexIterator() noexcept :
+			value(0)
+		{}
+
+		explicit IndexIterator(size_t value) noexcept :
+			value(value)
+		{}
+
+		reference operator*() const { return value; }
+		value_type operator[](difference_type n) const { return value + n; }
+
+		IndexIterator& operator++() { ++value; return *this; }
+		IndexIterator operator++(int) { IndexIterator it = *this; ++value; return it; }
+		IndexIterator& operator--() { --value; return *this; }
+		IndexIterator operator--(int) { IndexIterator it = *this; --value; return it; }
+		IndexIterator& operator+=(difference_type n) { value += n; return *this; }
+		IndexIterator& operator-=(difference_type n) { value -= n; return *this; }
+
+		friend IndexIterator operator+(IndexIterator it, difference_type n) { return IndexIterator(it.value + n); }
+		friend IndexIterator operator+(difference_type n, IndexIterator it) { return IndexIterator(it.value + n); }
+		friend IndexIterator operator-(IndexIterator it, difference_type n) { return IndexIterator(it.value - n); }
+		friend difference_type operator-(IndexIterator a, IndexIterator b) { return (difference_type)a.value - (difference_type)b.value; }
+
+		friend bool operator==(IndexIterator a, IndexIterator b) { return a.value == b.value; }
+		friend bool operator!=(IndexIterator a, IndexIterator b) { return a.value != b.value; }
+		friend bool operator<(IndexIterator a, IndexIterator b) { return a.value < b.value; }
+		friend bool operator>(IndexIterator a, IndexIterator b) { return a.value > b.value; }
+		friend bool operator<=(IndexIterator a, IndexIterator b) { return a.value <= b.value; }
+		friend bool operator>=(IndexIterator a, IndexIterator b) { return a.value >= b.value; }
+
+	private:
+		size_t value;
+	};
+
+	//Calls f(i) for every i in [0, count) in parallel
+	template <typename Function>
+	void parallelFor(size_t count, Function &&f)
+	{
+		std::for_each(
+			std::execution::par,
+			IndexIterator(0),
+			IndexIterator(count),
+			[&f](size_t i) { f(i); });
+	}
+
+	//Indices per partial result of parallelReduce
+	constexpr size_t REDUCE_BLOCK_SIZE = 4096;
+
+	//Reduces map(i) for every i in [0, count) with combine. Every block of REDUCE_BLOCK_SIZE indices is reduced
+	//in index order into its own partial, and the partials are combined in block order, so the result only
+	//depends on count and not on the thread count or scheduling, even for floating point sums.
+	//map may have side effects, it is called exactly once per index.
+	template <typename T, typename Map, typename Combine>
+	T parallelReduce(size_t count, T identity, Map &&map, Combine &&combine)
+	{
+		size_t numBlocks = (count + REDUCE_BLOCK_SIZE - 1) / REDUCE_BLOCK_SIZE;
+		std::vector<T> partials(numBlocks, identity);
+
+		parallelFor(
+			numBlocks,
+			[&](size_t block)
+			{
+				size_t last = std::min(count, (block + 1) * REDUCE_BLOCK_SIZE);
+				T partial = identity;
+
+				for (size_t i = block * REDUCE_BLOCK_SIZE; i < last; i++) partial = combine(partial, map(i));
+
+				partials[block] = partial;
+			});
+
+		T result = identity;
+		for (const T &partial : partials) result = combine(result, partial);
+
+		return result;
+	}
+
+	template <typename T, typename Map>
+	T parallelSum(size_t count, Map &&map)
+	{
+		return parallelReduce(count, T(0), map, [](const T &a, const T &b) { return a + b; });
+	}
+
+	template <typename T, typename Map>
+	T parallelMax(size_t count, T identity, Map &&map)
+	{
+		return parallelReduce(count, identity, map, [](const T &a, const T &b) { return std::max(a, b); });
+	}
+
+	template <typename T, typename Map>
+	T parallelMin(size_t count, T identity, Map &&map)
+	{
+		return parallelReduce(count, identity, map, [](const T &a, const T &b) { return std::min(a, b); });
+	}
+
+}
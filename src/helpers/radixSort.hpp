@@ -0,0 +1,114 @@
+#pragma once
+
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+//Parallel least significant digit radix sort of (key, index) pairs.
+//Produces the permutation that orders the keys, ties keep their original order.
+//Passes over digits above the largest key are skipped, so small key ranges sort in few passes.
+template <typename Key>
+class RadixSorter
+{
+public:
+	void sort(const std::vector<Key> &keys, std::vector<uint32_t> &order)
+	{
+		size_t count = keys.size();
+
+		order.resize(count);
+		keysIn.resize(count);
+		keysOut.resize(count);
+		indicesOut.resize(count);
+
+		up::parallelFor(count, [&](size_t i) { keysIn[i] = keys[i]; order[i] = (uint32_t)i; });
+
+		if (count < 2) return;
+
+		Key maxKey = std::reduce(std::execution::par, keys.begin(), keys.end(), Key(0), [](Key a, Key b) { return std::max(a, b); });
+
+		//A few blocks per worker so small sorts still spread over every thread, but never blocks so
+		//small that the serial offset pass over the histograms dominates
+		size_t numWorkers = std::max(1u, std::thread::hardware_concurrency());
+		size_t blockSize = std::max(MIN_BLOCK_SIZE, (count + BLOCKS_PER_WORKER * numWorkers - 1) / (BLOCKS_PER_WORKER * numWorkers));
+		int numBlocks = (int)((count + blockSize - 1) / blockSize);
+		histograms.resize(numBlocks);
+
+		for (int shift = 0; shift < (int)(8 * sizeof(Key)) && (maxKey >> shift) != 0; shift += RADIX_BITS)
+		{
+			//Digit histogram of every block
+			up::parallelFor(
+				numBlocks,
+				[&](size_t block)
+				{
+					Histogram &histogram = histograms[block];
+					histogram.fill(0);
+
+					size_t last = std::min(count, (block + 1) * blockSize);
+					for (size_t i = block * blockSize; i < last; i++) histogram[digit(keysIn[i], shift)]++;
+				});
+
+			//Exclusive offsets, ordered by digit first and block second so the sort stays stable
+			uint32_t offset = 0;
+
+			for (size_t d = 0; d < RADIX; d++)
+			{
+				for (int block = 0; block < numBlocks; block++)
+				{
+					uint32_t blockCount = histograms[block][d];
+					histograms[block][d] = offset;
+					offset += blockCount;
+				}
+			}
+
+			//Scatter every block into its reserved slots
+			up::parallelFor(
+				numBlocks,
+				[&](size_t block)
+				{
+					Histogram &histogram = histograms[block];
+
+					size_t last = std::min(count, (block + 1) * blockSize);
+					for (size_t i = block * blockSize; i < last; i++)
+					{
+						uint32_t destination = histogram[digit(keysIn[i], shift)]++;
+						keysOut[destination] = keysIn[i];
+						indicesOut[destination] = order[i];
+					}
+				});
+
+			keysIn.swap(keysOut);
+			order.swap(indicesOut);
+		}
+	}
+
+	//Keys of the last sort in sorted order
+	const std::vector<Key> &sortedKeys() const
+	{
+		return keysIn;
+	}
+
+private:
+	static constexpr int RADIX_BITS = 8;
+	static constexpr size_t RADIX = (size_t)1 << RADIX_BITS;
+	static constexpr size_t MIN_BLOCK_SIZE = 1 << 12;
+	static constexpr size_t BLOCKS_PER_WORKER = 4;
+
+	using Histogram = std::array<uint32_t, RADIX>;
+
+	std::vector<Key> keysIn;
+	std::vector<Key> keysOut;
+	std::vector<uint32_t> indicesOut;
+	std::vector<Histogram> histograms;
+
+	static size_t digit(Key key, int shift)
+	{
+		return (size_t)((key >> shift) & (RADIX - 1));
+	}
+};
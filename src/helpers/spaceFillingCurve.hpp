@@ -0,0 +1,144 @@
+#pragma once
+
+#include "helpers/hilbert.hpp"
+#include "helpers/morton.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+//Space filling curve policies of the grid neighbor search. Every policy maps grid cell coordinates
+//to 64 bit keys (encode), back (decode), and yields the keys of the 3x3 stencil around a cell.
+//Cell coordinates and their stencil neighbors are never negative, the grid keeps a one cell margin.
+namespace up::curve
+{
+	//Extent of the grid the keys are computed on
+	struct Grid
+	{
+		uint32_t cellsInX = 0;
+		uint32_t cellsInY = 0;
+	};
+
+	using StencilKeys = std::array<uint64_t, 9>;
+
+	//Closed interval [first, last] of consecutive keys
+	struct KeyInterval
+	{
+		uint64_t first;
+		uint64_t last;
+	};
+
+	using StencilIntervals = std::array<KeyInterval, 9>;
+
+	//Covers count stencil keys with the fewest intervals of consecutive keys and returns how many.
+	//Along the Z order a 3x3 block splits into a handful of runs wherever the curve leaves and reenters it,
+	//the points BIGMIN/LITMAX would jump between. With nine cells sorting and merging the keys finds them directly.
+	inline size_t planIntervals(const uint64_t *keys, size_t count, StencilIntervals &intervals)
+	{
+		std::array<uint64_t, 9> sorted;
+		std::copy(keys, keys + count, sorted.begin());
+		std::sort(sorted.begin(), sorted.begin() + count);
+
+		size_t numIntervals = 0;
+
+		for (size_t s = 0; s < count; s++)
+		{
+			if (numIntervals > 0 && sorted[s] == intervals[numIntervals - 1].last + 1) intervals[numIntervals - 1].last = sorted[s];
+			else intervals[numIntervals++] = { sorted[s], sorted[s] };
+		}
+
+		return numIntervals;
+	}
+
+	//Row by row, the XYZ order
+	struct RowMajor
+	{
+		static constexpr const char *NAME = "XYZ";
+
+		static uint64_t encode(const Grid &grid, uint32_t x, uint32_t y)
+		{
+			return (uint64_t)y * grid.cellsInX + x;
+		}
+
+		static void decode(const Grid &grid, uint64_t key, uint32_t &x, uint32_t &y)
+		{
+			x = (uint32_t)(key % grid.cellsInX);
+			y = (uint32_t)(key / grid.cellsInX);
+		}
+
+		static void stencil(const Grid &grid, uint64_t key, StencilKeys &keys)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++) keys[(dy + 1) * 3 + dx + 1] = key + (int64_t)dy * grid.cellsInX + dx;
+			}
+		}
+	};
+
+	//Z order, the ZIndex curve
+	struct Morton
+	{
+		static constexpr const char *NAME = "ZIndex";
+
+		static uint64_t encode(const Grid &, uint32_t x, uint32_t y)
+		{
+			return morton::encode(x, y);
+		}
+
+		static void decode(const Grid &, uint64_t key, uint32_t &x, uint32_t &y)
+		{
+			morton::decode(key, x, y);
+		}
+
+		//Steps the interleaved coordinates directly with dilated integer arithmetic, no decode needed
+		static void stencil(const Grid &, uint64_t key, StencilKeys &keys)
+		{
+			uint64_t x = key & morton::EVEN_BITS;
+			uint64_t y = key & morton::ODD_BITS;
+
+			uint64_t xs[3] = { (x - 1) & morton::EVEN_BITS, x, ((x | morton::ODD_BITS) + 1) & morton::EVEN_BITS };
+			uint64_t ys[3] = { (y - 2) & morton::ODD_BITS, y, ((y | morton::EVEN_BITS) + 2) & morton::ODD_BITS };
+
+			for (int dy = 0; dy < 3; dy++)
+			{
+				for (int dx = 0; dx < 3; dx++) keys[dy * 3 + dx] = xs[dx] | ys[dy];
+			}
+		}
+	};
+
+	//Hilbert order, the HILBERT curve. Keys use 32 bits while the grid fits in 2^16 cells per axis.
+	struct Hilbert
+	{
+		static constexpr const char *NAME = "HILBERT";
+
+		static bool wideKeys(const Grid &grid)
+		{
+			return grid.cellsInX > (1u << 16) || grid.cellsInY > (1u << 16);
+		}
+
+		static uint64_t encode(const Grid &grid, uint32_t x, uint32_t y)
+		{
+			if (wideKeys(grid)) return hilbert::encode<uint64_t>(x, y);
+			return hilbert::encode<uint32_t>(x, y);
+		}
+
+		static void decode(const Grid &grid, uint64_t key, uint32_t &x, uint32_t &y)
+		{
+			if (wideKeys(grid)) hilbert::decode<uint64_t>(key, x, y);
+			else hilbert::decode<uint32_t>((uint32_t)key, x, y);
+		}
+
+		static void stencil(const Grid &grid, uint64_t key, StencilKeys &keys)
+		{
+			uint32_t x;
+			uint32_t y;
+			decode(grid, key, x, y);
+
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++) keys[(dy + 1) * 3 + dx + 1] = encode(grid, x + dx, y + dy);
+			}
+		}
+	};
+}
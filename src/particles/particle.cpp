@@ -1,19 +1,18 @@
 #pragma once
 
 #include "particle.hpp"
-#include <SFML/Graphics.hpp>
 #include "helpers/vector2.hpp"
 #include <vector>
 #include <memory>
 
-Particle2::Particle2(up::Vec2 pos_current, float particle_radius, sf::Color particle_color)
+Particle2::Particle2(up::Vec2 pos_current, float particle_radius, up::Color particle_color)
 {
 	up::Vec2 position_current = pos_current;
 	up::Vec2 position_old = pos_current;
 	up::Vec2 acceleration = { 0.f, 0.f };
 	float radius = particle_radius;
 	bool isBoundary = false;
-	sf::Color color = particle_color;
+	up::Color color = particle_color;
 }
 
 // Verlet integration
@@ -1,18 +1,19 @@
 #pragma once
-#include <SFML/Graphics.hpp>
+#include "helpers/color.hpp"
 #include "helpers/vector2.hpp"
 #include <vector>
+#include <memory>
 
 class Particle2 {
 
 public:
-	Particle2(up::Vec2 pos_current, float particle_radius, sf::Color particle_color);
+	Particle2(up::Vec2 pos_current, float particle_radius, up::Color particle_color);
 	up::Vec2 position_current;
 	up::Vec2 position_old;
 	up::Vec2 acceleration;
 	float radius;
 	bool isBoundary;
-	sf::Color color;
+	up::Color color;
 
 	up::Vec2 velocity = { 0.0f, 0.0f };
 	up::Vec2 forces = { 0.0f, 0.0f };
@@ -0,0 +1,82 @@
+#include "particleStore.hpp"
+#include "helpers/parallel.hpp"
+
+size_t ParticleStore::add(up::Vec2 particlePosition, float particleVolume, bool particleIsBoundary, up::Color particleColor,
+	bool particleIsTheOne, bool particleIsMovableBoundary)
+{
+	float particleDensity = 1.0f;
+	float particleMass = particleVolume * particleDensity;
+
+	position.push_back(particlePosition);
+	velocity.push_back({ 0.f, 0.f });
+	predictedVelocity.push_back({ 0.f, 0.f });
+	forces.push_back({ 0.f, 0.f });
+	pressureAcceleration.push_back({ 0.f, 0.f });
+	viscosityAcceleration.push_back({ 0.f, 0.f });
+
+	density.push_back(particleDensity);
+	pressure.push_back(0.f);
+	mass.push_back(particleMass);
+	volume.push_back(particleVolume);
+	radius.push_back(sqrt(particleVolume) / 2);
+
+	diagonalElement.push_back(0.f);
+	predictedDensityError.push_back(0.f);
+	negVelocityDivergence.push_back(0.f);
+
+	isBoundary.push_back(particleIsBoundary);
+	isMovableBoundary.push_back(particleIsMovableBoundary);
+	theOne.push_back(particleIsTheOne);
+	isTheOneNeighbor.push_back(false);
+
+	gridCellIndex.push_back(0);
+	color.push_back(particleColor);
+
+	return position.size() - 1;
+}
+
+void ParticleStore::clear()
+{
+	position.clear();
+	velocity.clear();
+	predictedVelocity.clear();
+	forces.clear();
+	pressureAcceleration.clear();
+	viscosityAcceleration.clear();
+
+	density.clear();
+	pressure.clear();
+	mass.clear();
+	volume.clear();
+	radius.clear();
+
+	diagonalElement.clear();
+	predictedDensityError.clear();
+	negVelocityDivergence.clear();
+
+	isBoundary.clear();
+	isMovableBoundary.clear();
+	theOne.clear();
+	isTheOneNeighbor.clear();
+
+	gridCellIndex.clear();
+	color.clear();
+}
+
+void ParticleStore::permute(const std::vector<uint32_t> &order, ParticleStore &scratch)
+{
+	size_t count = order.size();
+
+	forEachArray(scratch, [count](auto &, auto &permuted) { permuted.resize(count); });
+
+	up::parallelFor(
+		count,
+		[this, &order, &scratch](size_t i)
+		{
+			uint32_t source = order[i];
+
+			forEachArray(scratch, [i, source](auto &values, auto &permuted) { permuted[i] = values[source]; });
+		});
+
+	forEachArray(scratch, [](auto &values, auto &permuted) { values.swap(permuted); });
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "helpers/color.hpp"
+#include "helpers/vector2.hpp"
+
+#include <cstdint>
+#include <vector>
+
+//Structure of arrays holding the state of every particle. Particle i is the i-th entry of each array.
+struct ParticleStore {
+
+	std::vector<up::Vec2> position;
+	std::vector<up::Vec2> velocity;
+	std::vector<up::Vec2> predictedVelocity;
+	std::vector<up::Vec2> forces;
+	std::vector<up::Vec2> pressureAcceleration;
+	std::vector<up::Vec2> viscosityAcceleration;
+
+	std::vector<float> density;
+	std::vector<float> pressure;
+	std::vector<float> mass;
+	std::vector<float> volume;
+	std::vector<float> radius;
+
+	std::vector<float> diagonalElement;
+	std::vector<float> predictedDensityError;
+	std::vector<float> negVelocityDivergence;
+
+	std::vector<uint8_t> isBoundary;
+	std::vector<uint8_t> isMovableBoundary;
+	std::vector<uint8_t> theOne;
+	std::vector<uint8_t> isTheOneNeighbor;
+
+	std::vector<uint64_t> gridCellIndex;
+	std::vector<up::Color> color;
+
+	size_t size() const { return position.size(); }
+	bool empty() const { return position.empty(); }
+
+	size_t add(up::Vec2 particlePosition, float particleVolume, bool particleIsBoundary, up::Color particleColor,
+		bool particleIsTheOne = false, bool particleIsMovableBoundary = false);
+	void clear();
+
+	//Reorders every array so that the new particle i is the old particle order[i].
+	//All attributes move in a single parallel pass through the arrays of scratch, which is left holding the old data.
+	void permute(const std::vector<uint32_t> &order, ParticleStore &scratch);
+
+	void updateVolume(size_t i)
+	{
+		volume[i] = mass[i] / density[i];
+		radius[i] = sqrt(volume[i]) / 2;
+	}
+
+	//Calls f(array, otherArray) for every attribute array of this store and the matching array of other
+	template <typename Function>
+	void forEachArray(ParticleStore &other, Function &&f)
+	{
+		f(position, other.position);
+		f(velocity, other.velocity);
+		f(predictedVelocity, other.predictedVelocity);
+		f(forces, other.forces);
+		f(pressureAcceleration, other.pressureAcceleration);
+		f(viscosityAcceleration, other.viscosityAcceleration);
+
+		f(density, other.density);
+		f(pressure, other.pressure);
+		f(mass, other.mass);
+		f(volume, other.volume);
+		f(radius, other.radius);
+
+		f(diagonalElement, other.diagonalElement);
+		f(predictedDensityError, other.predictedDensityError);
+		f(negVelocityDivergence, other.negVelocityDivergence);
+
+		f(isBoundary, other.isBoundary);
+		f(isMovableBoundary, other.isMovableBoundary);
+		f(theOne, other.theOne);
+		f(isTheOneNeighbor, other.isTheOneNeighbor);
+
+		f(gridCellIndex, other.gridCellIndex);
+		f(color, other.color);
+	}
+};
@@ -82,7 +82,7 @@ void Renderer::RenderSimulation() {
 	m_window.setView(view);
 	m_window.display();
 
-	if(m_solver.updating) m_solver.simDataFile << "," << renderClock.getElapsedTime().asMilliseconds() << std::endl;
+	if(m_solver.updating) m_solver.finishDataRow(renderClock.getElapsedTime().asMilliseconds());
 
 	if (isRecording) {
 		handleTakeScreenShot();
@@ -107,46 +107,54 @@ void Renderer::handleTakeScreenShot()
 void Renderer::RenderParticles(std::string &screenText) {
 	float particleDim = m_solver.PARTICLE_SPACING;
 
-	for (auto & p : m_solver.particles)
+	const ParticleStore &ps = m_solver.particles;
+
+	for (size_t i = 0; i < ps.size(); i++)
 	{
 		sf::RectangleShape shape(sf::Vector2f(particleDim, particleDim));
-		shape.setOrigin(p->radius, p->radius);
+		shape.setOrigin(ps.radius[i], ps.radius[i]);
 
-		if (p->isBoundary) {
-			shape.setFillColor(p->color);
+		if (ps.isBoundary[i]) {
+			shape.setFillColor(sf::Color(ps.color[i].r, ps.color[i].g, ps.color[i].b, ps.color[i].a));
 		}
 		else {
 			float maxPressureValue = 2000.f;
-			float particlePressure = p->pressureAcceleration.length() > maxPressureValue ? maxPressureValue : p->pressureAcceleration.length();
+			float particlePressure = ps.pressureAcceleration[i].length() > maxPressureValue ? maxPressureValue : ps.pressureAcceleration[i].length();
 			sf::Color pressureColor = sf::Color((int)(particlePressure / maxPressureValue * 255), (int)(particlePressure / maxPressureValue * 255), 255, 255);
 			shape.setFillColor(sf::Color::Blue);
 		}
 
-		shape.setPosition(p->position_current.x, p->position_current.y);
+		shape.setPosition(ps.position[i].x, ps.position[i].y);
 
-		if (p->isTheOneNeighbor) shape.setFillColor(sf::Color::Magenta);
-		else if (p->theOne) shape.setFillColor(sf::Color::Green);
+		if (ps.isTheOneNeighbor[i]) shape.setFillColor(sf::Color::Magenta);
+		else if (ps.theOne[i]) shape.setFillColor(sf::Color::Green);
 
 		m_window.draw(shape);
 
-		if (showInfo && p->theOne) {
-			sf::Text particleCellText(std::to_string(p->gridCellIndex), font, 12);
+		if (showInfo && ps.theOne[i]) {
+			sf::Text particleCellText(std::to_string(ps.gridCellIndex[i]), font, 12);
 			particleCellText.setFillColor(sf::Color::White);
-			particleCellText.setPosition(p->position_current.x, p->position_current.y);
+			particleCellText.setPosition(ps.position[i].x, ps.position[i].y);
 			m_window.draw(particleCellText);
 			screenText.append("\n");
-			screenText.append("\nNeighbor search index: " + std::to_string(p->gridCellIndex));
-			screenText.append("\nNeighbors: " + std::to_string(p->neighbors.size()) + " fluid, " + std::to_string(p->neighborsBoundary.size()) + " boundary");
-			screenText.append("\nDensity: " + std::to_string(p->density));
-			screenText.append("\nVolume: " + std::to_string(p->volume));
-			screenText.append("\nPressure: " + std::to_string(p->pressure));
-			screenText.append("\nRadius: " + std::to_string(p->radius));
-			screenText.append("\nVelocity: " + std::to_string((int)p->velocity.x) + ", " + std::to_string((int)p->velocity.y));
-			screenText.append("\nPredicted density error: " + std::to_string(p->predictedDensityError));
-			screenText.append("\nDiagonal element: " + std::to_string(p->diagonalElement));
-			screenText.append("\nPosition: " + std::to_string((int)p->position_current.x) + ", " + std::to_string((int)p->position_current.y));
-			screenText.append("\nPressure acceleration: " + std::to_string((int)p->pressureAcceleration.x) + ", " + std::to_string((int)p->pressureAcceleration.y));
-			screenText.append("\nViscosity acceleration: " + std::to_string((int)p->viscosityAcceleration.x) + ", " + std::to_string((int)p->viscosityAcceleration.y));
+			screenText.append("\nNeighbor search index: " + std::to_string(ps.gridCellIndex[i]));
+			if (i < m_solver.neighbors.numParticles()) {
+				size_t fluidNeighbors = 0;
+				size_t boundaryNeighbors = 0;
+				m_solver.neighbors.forEachFluid(i, ps, [&](size_t, uint32_t) { fluidNeighbors++; });
+				m_solver.neighbors.forEachBoundary(i, ps, [&](size_t, uint32_t) { boundaryNeighbors++; });
+				screenText.append("\nNeighbors: " + std::to_string(fluidNeighbors) + " fluid, " + std::to_string(boundaryNeighbors) + " boundary");
+			}
+			screenText.append("\nDensity: " + std::to_string(ps.density[i]));
+			screenText.append("\nVolume: " + std::to_string(ps.volume[i]));
+			screenText.append("\nPressure: " + std::to_string(ps.pressure[i]));
+			screenText.append("\nRadius: " + std::to_string(ps.radius[i]));
+			screenText.append("\nVelocity: " + std::to_string((int)ps.velocity[i].x) + ", " + std::to_string((int)ps.velocity[i].y));
+			screenText.append("\nPredicted density error: " + std::to_string(ps.predictedDensityError[i]));
+			screenText.append("\nDiagonal element: " + std::to_string(ps.diagonalElement[i]));
+			screenText.append("\nPosition: " + std::to_string((int)ps.position[i].x) + ", " + std::to_string((int)ps.position[i].y));
+			screenText.append("\nPressure acceleration: " + std::to_string((int)ps.pressureAcceleration[i].x) + ", " + std::to_string((int)ps.pressureAcceleration[i].y));
+			screenText.append("\nViscosity acceleration: " + std::to_string((int)ps.viscosityAcceleration[i].x) + ", " + std::to_string((int)ps.viscosityAcceleration[i].y));
 		}
 	}
 }
@@ -198,7 +206,7 @@ void Renderer::ProcessEvents()
 		switch (event.type)
 		{
 		case sf::Event::KeyPressed:
-			if (event.key.code == sf::Keyboard::A) m_solver.addParticle((float)trueMousePos.x, (float)trueMousePos.y, false, sf::Color::Blue);
+			if (event.key.code == sf::Keyboard::A) m_solver.addParticle((float)trueMousePos.x, (float)trueMousePos.y, false, up::Color::Blue);
 			else if (event.key.code == sf::Keyboard::U) m_solver.updating = !m_solver.updating;
 			else if (event.key.code == sf::Keyboard::O) isRecording = !isRecording;
 			else if (event.key.code == sf::Keyboard::N) m_solver.initializeLiquidParticles(500000);
@@ -221,7 +229,7 @@ void Renderer::ProcessEvents()
 			else if (event.key.code == sf::Keyboard::X) m_solver.initializeMovingParticlesCircle((float)trueMousePos.x, (float)trueMousePos.y, 50.f, false);
 			break;
 		case sf::Event::MouseButtonPressed:
-			if (event.mouseButton.button == sf::Mouse::Right) m_solver.addParticle((float)trueMousePos.x, (float)trueMousePos.y, false, sf::Color::Green, true);
+			if (event.mouseButton.button == sf::Mouse::Right) m_solver.addParticle((float)trueMousePos.x, (float)trueMousePos.y, false, up::Color::Green, true);
 			else if (event.mouseButton.button == sf::Mouse::Left) {
 				holdingClick = true;
 				initialPreviewPosition = sf::Vector2f(trueMousePos.x, trueMousePos.y);
@@ -230,7 +238,7 @@ void Renderer::ProcessEvents()
 		case sf::Event::MouseButtonReleased:
 			if (event.mouseButton.button == sf::Mouse::Left) {
 				holdingClick = false;
-				m_solver.initializeLiquidParticles(initialPreviewPosition, sf::Vector2f(trueMousePos.x, trueMousePos.y));
+				m_solver.initializeLiquidParticles(up::Vec2(initialPreviewPosition.x, initialPreviewPosition.y), up::Vec2(trueMousePos.x, trueMousePos.y));
 			}
 		case sf::Event::MouseWheelScrolled: {
 			float zoomFactor = 1.0f - event.mouseWheelScroll.delta * 0.1f;
@@ -225,11 +225,13 @@ void ORenderer3D::onUpdateInternal()
 	m_graphicsEngine->setUniformBuffer(m_uniform, 0);
 	m_graphicsEngine->setShaderProgram(m_shader);
 
-	for (auto & p : m_solver.particles)
+	const ParticleStore &ps = m_solver.particles;
+
+	for (size_t i = 0; i < ps.size(); i++)
 	{
 		OMat4 entityWorld = world;
 
-		OVec3 position = { p->position_current.x/200 - 3, p->position_current.y/200 - 2.1f, 0.f };
+		OVec3 position = { ps.position[i].x/200 - 3, ps.position[i].y/200 - 2.1f, 0.f };
 		entityWorld.setTranslation(position);
 
 		UniformData data = { entityWorld, projection };
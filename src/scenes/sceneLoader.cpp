@@ -0,0 +1,163 @@
+#include "sceneLoader.hpp"
+
+#include <fstream>
+#include <sstream>
+
+SceneLoader::SceneLoader(Solver &_solver)
+	: solver(_solver)
+{
+}
+
+bool SceneLoader::load(const std::string &scene, int fluidParticles)
+{
+	error.clear();
+
+	if (loadBuiltIn(scene, fluidParticles)) return true;
+	if (!error.empty()) return false;
+
+	return loadFile(scene);
+}
+
+const std::string &SceneLoader::getError() const
+{
+	return error;
+}
+
+bool SceneLoader::loadBuiltIn(const std::string &name, int fluidParticles)
+{
+	if (name == "dambreak")
+	{
+		if (fluidParticles <= 0) {
+			error = "dambreak scene needs a positive particle count";
+			return false;
+		}
+
+		solver.initializeBoundaryParticlesSquare();
+		solver.initializeLiquidParticles(fluidParticles);
+		return true;
+	}
+
+	return false;
+}
+
+bool SceneLoader::loadFile(const std::string &path)
+{
+	std::ifstream sceneFile(path);
+
+	if (!sceneFile.is_open()) {
+		error = "could not open scene '" + path + "'";
+		return false;
+	}
+
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(sceneFile, line))
+	{
+		lineNumber++;
+		if (!parseLine(line)) {
+			error = path + ":" + std::to_string(lineNumber) + ": " + error;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool SceneLoader::parseLine(const std::string &line)
+{
+	std::istringstream tokens(line);
+	std::string command;
+
+	if (!(tokens >> command) || command[0] == '#') return true;
+
+	if (command == "boundary")
+	{
+		std::string shape;
+		tokens >> shape;
+
+		if (shape == "square") solver.initializeBoundaryParticlesSquare();
+		else if (shape == "circle") solver.initializeBoundaryParticles();
+		else {
+			error = "unknown boundary shape '" + shape + "'";
+			return false;
+		}
+		return true;
+	}
+
+	if (command == "fluid")
+	{
+		std::string kind;
+		tokens >> kind;
+
+		if (kind == "block") {
+			float minX, minY, maxX, maxY;
+			if (!(tokens >> minX >> minY >> maxX >> maxY)) {
+				error = "fluid block expects <minX> <minY> <maxX> <maxY>";
+				return false;
+			}
+			solver.initializeLiquidParticles(up::Vec2(minX, minY), up::Vec2(maxX, maxY));
+			return true;
+		}
+
+		if (kind == "count") {
+			int count;
+			if (!(tokens >> count) || count <= 0) {
+				error = "fluid count expects a positive particle count";
+				return false;
+			}
+			solver.initializeLiquidParticles(count);
+			return true;
+		}
+
+		error = "unknown fluid kind '" + kind + "'";
+		return false;
+	}
+
+	if (command == "wall")
+	{
+		float x0, y0, x1, y1;
+		std::string flag;
+		if (!(tokens >> x0 >> y0 >> x1 >> y1)) {
+			error = "wall expects <x0> <y0> <x1> <y1> [movable]";
+			return false;
+		}
+		bool isMovable = (tokens >> flag) && flag == "movable";
+
+		//Walls are placed by two clicks in the viewer, replay them
+		solver.handleAddWall(x0, y0, isMovable);
+		solver.handleAddWall(x1, y1, isMovable);
+		return true;
+	}
+
+	if (command == "circle")
+	{
+		float x, y, radiusCircle;
+		std::string flag;
+		if (!(tokens >> x >> y >> radiusCircle)) {
+			error = "circle expects <x> <y> <radius> [movable]";
+			return false;
+		}
+		bool isMovable = (tokens >> flag) && flag == "movable";
+
+		solver.initializeMovingParticlesCircle(x, y, radiusCircle, isMovable);
+		return true;
+	}
+
+	if (command == "particle")
+	{
+		float x, y;
+		std::string kind;
+		if (!(tokens >> x >> y >> kind) || (kind != "fluid" && kind != "boundary")) {
+			error = "particle expects <x> <y> fluid|boundary";
+			return false;
+		}
+		bool isBoundary = kind == "boundary";
+
+		solver.addParticle(x, y, isBoundary, isBoundary ? up::Color::Red : up::Color::Blue);
+		return true;
+	}
+
+	error = "unknown command '" + command + "'";
+	return false;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "solvers/solver.hpp"
+
+#include <string>
+
+//Populates a solver from a scene description.
+//
+//A scene is either the name of a built-in setup ("dambreak") or the path to a text file
+//with one command per line, mirroring the interactive tools of the viewer:
+//
+//	boundary square
+//	boundary circle
+//	fluid block <minX> <minY> <maxX> <maxY>
+//	fluid count <numParticles>
+//	wall <x0> <y0> <x1> <y1> [movable]
+//	circle <x> <y> <radius> [movable]
+//	particle <x> <y> fluid|boundary
+//
+//Empty lines and lines starting with '#' are ignored.
+class SceneLoader {
+
+public:
+	SceneLoader(Solver &solver);
+
+	bool load(const std::string &scene, int fluidParticles);
+	const std::string &getError() const;
+
+private:
+	Solver &solver;
+	std::string error;
+
+	bool loadBuiltIn(const std::string &name, int fluidParticles);
+	bool loadFile(const std::string &path);
+	bool parseLine(const std::string &line);
+};
@@ -0,0 +1,288 @@
+#include "conjugateGradientSolver.hpp"
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <execution>
+#include <numeric>
+
+void ConjugateGradientSolver::compute()
+{
+	ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	initialize();
+
+	//The initial guess, zero or warm started
+	pressure = ps.pressure;
+	residual.assign(numParticles, 0.f);
+	preconditioned.assign(numParticles, 0.f);
+	shadowResidual.assign(numParticles, 0.f);
+	direction.assign(numParticles, 0.f);
+	product.assign(numParticles, 0.f);
+	stabilizerProduct.assign(numParticles, 0.f);
+	isActive.resize(numParticles);
+
+	//Only compressed particles and warm started ones start with an unknown pressure, the free surface starts fixed at zero.
+	//Isolated particles have no diagonal, like the Jacobi solver they keep zero pressure.
+	up::parallelFor(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			isActive[i] = !ps.isBoundary[i] && ps.diagonalElement[i] != 0.f && (ps.predictedDensityError[i] < 0.f || pressure[i] > 0.f);
+			if (!isActive[i]) pressure[i] = 0.f;
+		});
+
+	numIterations = 0;
+
+	int iterationBudget = MAX_ITERATIONS;
+	float densityErrorAvg = solve(iterationBudget);
+
+	for (int restart = 0; restart < MAX_RESTARTS && updateActiveSet(densityErrorAvg > MAX_DENSITY_ERROR); restart++) densityErrorAvg = solve(iterationBudget);
+
+	//The final pressure field and its accelerations are what applyPressureForce reads
+	up::parallelFor(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			pressure[i] = std::max(pressure[i], 0.f);
+			ps.pressure[i] = pressure[i];
+		});
+
+	//Clamping changes the residual, the error is measured again on the pressure that is kept
+	computeResidual();
+	densityErrorAvg = residualErrors().compression;
+
+	//The solve can stop above the tolerance, out of iterations or restarts.
+	//Relaxed Jacobi from the clamped pressure then finishes it with the same criterion.
+	numFallbackIterations = 0;
+
+	while (densityErrorAvg > MAX_DENSITY_ERROR)
+	{
+		if (numFallbackIterations >= MAX_FALLBACK_ITERATIONS) break;
+
+		densityErrorAvg = iterate();
+		numFallbackIterations++;
+	}
+
+	numIterations += numFallbackIterations;
+
+	computePressureAccelerations(ps.pressure);
+
+	writeStatistics(densityErrorAvg);
+}
+
+//y = -A x, A x being the divergence of the velocity change caused by the pressure field x
+void ConjugateGradientSolver::applyOperator(const std::vector<float> &x, std::vector<float> &y)
+{
+	ParticleStore &ps = *particles;
+
+	computePressureAccelerations(x);
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps, &y](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			y[i] = -computeDivergence(i);
+		});
+}
+
+//r = -s - (-A p) for every fluid particle, fixed ones included so the density error stays exact
+void ConjugateGradientSolver::computeResidual()
+{
+	const ParticleStore &ps = *particles;
+
+	applyOperator(pressure, product);
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			residual[i] = -ps.predictedDensityError[i] - product[i];
+		});
+}
+
+//Runs right preconditioned BiCGSTAB on the active particles until the density error criterion of the Jacobi solver holds,
+//or until the active particles are solved and only fixed ones are left to fix by a change of the active set.
+//Fixed particles keep a zero correction, but their residual is still updated and counts towards the error.
+//When a step breaks down, rho or (r^, v) vanishing, the shadow residual restarts from the current residual.
+float ConjugateGradientSolver::solve(int &iterationBudget)
+{
+	size_t numParticles = particles->size();
+
+	computeResidual();
+
+	float rho = 1.f;
+	float alpha = 1.f;
+	float omega = 1.f;
+	bool restarted = false;
+
+	auto restart = [this, numParticles, &rho, &alpha, &omega, &restarted]()
+	{
+		up::parallelFor(
+			numParticles,
+			[this](size_t i)
+			{
+				shadowResidual[i] = isActive[i] ? residual[i] : 0.f;
+				direction[i] = 0.f;
+				product[i] = 0.f;
+			});
+
+		rho = alpha = omega = 1.f;
+		restarted = true;
+	};
+
+	restart();
+
+	ResidualErrors errors = residualErrors();
+
+	while (iterationBudget > 0 && (numIterations < MIN_ITERATIONS || (errors.compression > MAX_DENSITY_ERROR && errors.active > MAX_ACTIVE_ERROR)))
+	{
+		float nextRho = dot(shadowResidual, residual);
+
+		if (nextRho == 0.f) {
+			//Right after a restart the active residual is zero, the active particles are solved
+			if (restarted) break;
+
+			restart();
+			continue;
+		}
+
+		float beta = (nextRho / rho) * (alpha / omega);
+		rho = nextRho;
+
+		up::parallelFor(numParticles, [this, beta, omega](size_t i) { direction[i] = residual[i] + beta * (direction[i] - omega * product[i]); });
+
+		precondition(direction);
+		applyOperator(preconditioned, product);
+
+		float shadowProduct = dot(shadowResidual, product);
+
+		if (shadowProduct == 0.f) {
+			if (restarted) break;
+
+			restart();
+			continue;
+		}
+
+		alpha = rho / shadowProduct;
+
+		//First half step, the residual becomes s = r - alpha v
+		up::parallelFor(
+			numParticles,
+			[this, alpha](size_t i)
+			{
+				pressure[i] += alpha * preconditioned[i];
+				residual[i] -= alpha * product[i];
+			});
+
+		numIterations++;
+		iterationBudget--;
+		restarted = false;
+
+		errors = residualErrors();
+
+		if (numIterations >= MIN_ITERATIONS && (errors.compression <= MAX_DENSITY_ERROR || errors.active <= MAX_ACTIVE_ERROR)) break;
+
+		//Stabilizing half step, omega minimizes the residual along t = A M^-1 s
+		precondition(residual);
+		applyOperator(preconditioned, stabilizerProduct);
+
+		float stabilizerDot = dot(stabilizerProduct, stabilizerProduct);
+
+		if (stabilizerDot == 0.f) {
+			restart();
+			continue;
+		}
+
+		omega = dot(stabilizerProduct, residual) / stabilizerDot;
+
+		up::parallelFor(
+			numParticles,
+			[this, omega](size_t i)
+			{
+				pressure[i] += omega * preconditioned[i];
+				residual[i] -= omega * stabilizerProduct[i];
+			});
+
+		errors = residualErrors();
+
+		if (omega == 0.f) restart();
+	}
+
+	return errors.compression;
+}
+
+//Jacobi, x of the active particles scaled by the diagonal
+void ConjugateGradientSolver::precondition(const std::vector<float> &x)
+{
+	const ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	up::parallelFor(
+		numParticles,
+		[this, &ps, &x](size_t i) { preconditioned[i] = isActive[i] ? x[i] / -ps.diagonalElement[i] : 0.f; });
+}
+
+//Average compression left over, max(A p - s, 0) = max(r, 0), normalized like in PressureSolver::iterate,
+//and the average magnitude of the residual of the active particles, normalized the same way
+ConjugateGradientSolver::ResidualErrors ConjugateGradientSolver::residualErrors() const
+{
+	const ParticleStore &ps = *particles;
+
+	ResidualErrors sums = up::parallelReduce(
+		ps.size(),
+		ResidualErrors{ 0.f, 0.f },
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return ResidualErrors{ 0.f, 0.f };
+			return ResidualErrors{ std::max(residual[i], 0.f), isActive[i] ? std::abs(residual[i]) : 0.f };
+		},
+		[](const ResidualErrors &a, const ResidualErrors &b) { return ResidualErrors{ a.compression + b.compression, a.active + b.active }; });
+
+	float normalization = PARTICLE_REST_DENSITY * *numFluidParticles;
+
+	return { sums.compression / normalization, sums.active / normalization };
+}
+
+//Dot product over the active particles, the unknowns of the solve
+float ConjugateGradientSolver::dot(const std::vector<float> &a, const std::vector<float> &b) const
+{
+	return up::parallelSum<float>(a.size(), [this, &a, &b](size_t i) { return isActive[i] ? a[i] * b[i] : 0.f; });
+}
+
+//Fixes the active particles that ended with negative pressure at zero and frees the fixed particles that are
+//still compressed while the error is above the tolerance, r > 0 is the direction in which Jacobi would raise their pressure.
+//Returns whether the set changed.
+bool ConjugateGradientSolver::updateActiveSet(bool admitCompressed)
+{
+	const ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	changed.assign(numParticles, 0);
+
+	up::parallelFor(
+		numParticles,
+		[this, &ps, admitCompressed](size_t i)
+		{
+			if (ps.isBoundary[i] || ps.diagonalElement[i] == 0.f) return;
+
+			if (isActive[i] && pressure[i] < 0.f) {
+				pressure[i] = 0.f;
+				isActive[i] = false;
+				changed[i] = 1;
+			}
+			else if (admitCompressed && !isActive[i] && residual[i] > 0.f) {
+				isActive[i] = true;
+				changed[i] = 1;
+			}
+		});
+
+	return std::any_of(std::execution::par, changed.begin(), changed.end(), [](uint8_t c) { return c != 0; });
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "solvers/pressureSolver.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+//IISPH pressure solve with a matrix-free Jacobi preconditioned Krylov method instead of relaxed Jacobi.
+//The system and its diagonal are the ones of PressureSolver, the operator is applied through the same
+//pressure acceleration and divergence loops. The operator is not symmetric: a boundary neighbor adds 2 gamma p_i
+//to the pressure acceleration but enters the divergence once. Plain CG needs a symmetric positive definite system,
+//so the solve runs BiCGSTAB, the conjugate gradient variant for nonsymmetric systems, on -A p = -s.
+//Every iteration applies the operator twice.
+//Pressures must not become negative: the solve runs on an active set of particles with unknown pressure, the others
+//are fixed at zero, and the set is corrected and the solve restarted until it no longer changes.
+class ConjugateGradientSolver: public PressureSolver {
+
+public:
+	using PressureSolver::PressureSolver;
+	void compute() override;
+
+	//Relaxed Jacobi iterations of the last step that finished a solve left above the tolerance, included in numIterations
+	int numFallbackIterations = 0;
+
+private:
+	static constexpr int MAX_ITERATIONS = 1000;
+	static constexpr int MAX_RESTARTS = 8;
+	static constexpr int MAX_FALLBACK_ITERATIONS = 100;
+	static constexpr float MAX_ACTIVE_ERROR = 0.1f * MAX_DENSITY_ERROR;
+
+	struct ResidualErrors
+	{
+		float compression;
+		float active;
+	};
+
+	std::vector<float> pressure;
+	std::vector<float> residual;
+	//The fixed shadow residual of BiCGSTAB
+	std::vector<float> shadowResidual;
+	std::vector<float> preconditioned;
+	std::vector<float> direction;
+	std::vector<float> product;
+	std::vector<float> stabilizerProduct;
+	//Fluid particles whose pressure is still unknown, the others stay at zero
+	std::vector<uint8_t> isActive;
+	std::vector<uint8_t> changed;
+
+	void applyOperator(const std::vector<float> &x, std::vector<float> &y);
+	void computeResidual();
+	void precondition(const std::vector<float> &x);
+	float solve(int &iterationBudget);
+	ResidualErrors residualErrors() const;
+	float dot(const std::vector<float> &a, const std::vector<float> &b) const;
+	bool updateActiveSet(bool admitCompressed);
+};
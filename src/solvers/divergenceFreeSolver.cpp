@@ -0,0 +1,207 @@
+#include "divergenceFreeSolver.hpp"
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+DivergenceFreeSolver::DivergenceFreeSolver(ParticleStore *_particles, NeighborList *_neighbors, int *_numFluidParticles, float *_dt, std::ofstream *_simDataFile)
+{
+	particles = _particles;
+	neighbors = _neighbors;
+	numFluidParticles = _numFluidParticles;
+	dt = _dt;
+	simDataFile = _simDataFile;
+}
+
+//Densities and non-pressure forces are computed by the solver before, positions are updated after
+void DivergenceFreeSolver::compute()
+{
+	ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	alpha.resize(numParticles);
+	kappa.assign(numParticles, 0.f);
+	stiffness.assign(numParticles, 0.f);
+
+	computeAlpha();
+	correctDivergenceError();
+
+	//The non-pressure forces act on the divergence free velocity
+	up::parallelFor(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			ps.predictedVelocity[i] = ps.velocity[i] + (*dt) * ps.forces[i] / ps.mass[i];
+		});
+
+	stiffness.assign(numParticles, 0.f);
+
+	float densityErrorAvg = correctDensityError();
+
+	//Time integration adds dt * (forces / mass + pressureAcceleration) to the velocity, which yields the corrected one
+	up::parallelFor(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			ps.pressureAcceleration[i] = (ps.predictedVelocity[i] - ps.velocity[i]) / (*dt) - ps.forces[i] / ps.mass[i];
+			//kappa_i / rho_i plays the role of p_i / rho_i^2
+			ps.pressure[i] = stiffness[i] * ps.density[i];
+		});
+
+	writeStatistics(densityErrorAvg);
+}
+
+//Isolated particles get alpha = 0 and are left alone by both solves
+void DivergenceFreeSolver::computeAlpha()
+{
+	const ParticleStore &ps = *particles;
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			up::Vec2 gradientSum(0.f, 0.f);
+			float gradientSquaredSum = 0.f;
+
+			neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+				{
+					up::Vec2 gradient = ps.mass[j] * pairGradient(p, i, j);
+
+					gradientSum += gradient;
+					gradientSquaredSum += gradient.dot(gradient);
+				});
+
+			neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j) { gradientSum += ps.mass[j] * pairGradient(p, i, j); });
+
+			float denominator = gradientSum.dot(gradientSum) + gradientSquaredSum;
+
+			alpha[i] = denominator > 1e-6f ? ps.density[i] / denominator : 0.f;
+		});
+}
+
+//D rho_i / Dt for the given fluid velocities, boundaries move with their own velocity
+float DivergenceFreeSolver::densityChangeRate(size_t i, const std::vector<up::Vec2> &velocity) const
+{
+	const ParticleStore &ps = *particles;
+	float rate = 0.f;
+
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j) { rate += ps.mass[j] * (velocity[i] - velocity[j]).dot(pairGradient(p, i, j)); });
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j) { rate += ps.mass[j] * (velocity[i] - ps.velocity[j]).dot(pairGradient(p, i, j)); });
+
+	return rate;
+}
+
+//Removes the compressing part of the velocity divergence. Returns the average density change over one step
+//relative to the rest density.
+float DivergenceFreeSolver::correctDivergenceError()
+{
+	ParticleStore &ps = *particles;
+	float divergenceErrorAvg = 0.f;
+
+	numDivergenceIterations = 0;
+
+	while (true)
+	{
+		float divergenceSum = up::parallelSum<float>(
+			ps.size(),
+			[this, &ps](size_t i)
+			{
+				if (ps.isBoundary[i]) return 0.f;
+
+				float divergence = std::max(densityChangeRate(i, ps.velocity), 0.f);
+				kappa[i] = divergence / (*dt) * alpha[i];
+
+				return divergence;
+			});
+
+		divergenceErrorAvg = (*dt) * divergenceSum / PARTICLE_REST_DENSITY / *numFluidParticles;
+
+		if (numDivergenceIterations >= MAX_ITERATIONS) break;
+		if (divergenceErrorAvg <= MAX_DIVERGENCE_ERROR && numDivergenceIterations >= MIN_DIVERGENCE_ITERATIONS) break;
+
+		applyKappa(ps.velocity);
+		numDivergenceIterations++;
+	}
+
+	return divergenceErrorAvg;
+}
+
+//Corrects the predicted velocity until the predicted density error average is below the tolerance
+float DivergenceFreeSolver::correctDensityError()
+{
+	ParticleStore &ps = *particles;
+	float densityErrorAvg = 0.f;
+
+	numIterations = 0;
+
+	while (true)
+	{
+		float densityErrorSum = up::parallelSum<float>(
+			ps.size(),
+			[this, &ps](size_t i)
+			{
+				if (ps.isBoundary[i]) return 0.f;
+
+				float predictedDensity = ps.density[i] + (*dt) * densityChangeRate(i, ps.predictedVelocity);
+				float densityError = std::max(predictedDensity - PARTICLE_REST_DENSITY, 0.f);
+				kappa[i] = densityError / ((*dt) * (*dt)) * alpha[i];
+
+				return densityError;
+			});
+
+		densityErrorAvg = densityErrorSum / PARTICLE_REST_DENSITY / *numFluidParticles;
+
+		if (numIterations == 0) predictedDensityErrorAvg = densityErrorAvg;
+
+		if (numIterations >= MAX_ITERATIONS) break;
+		if (densityErrorAvg <= MAX_DENSITY_ERROR && numIterations >= MIN_DENSITY_ITERATIONS) break;
+
+		applyKappa(ps.predictedVelocity);
+		numIterations++;
+	}
+
+	return densityErrorAvg;
+}
+
+//v_i -= dt * sum m_j (kappa_i / rho_i + kappa_j / rho_j) grad W_ij, boundaries mirror kappa_i
+void DivergenceFreeSolver::applyKappa(std::vector<up::Vec2> &velocity)
+{
+	const ParticleStore &ps = *particles;
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps, &velocity](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			float kappaOverDensity = kappa[i] / ps.density[i];
+			up::Vec2 change(0.f, 0.f);
+
+			neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+				{
+					change += ps.mass[j] * (kappaOverDensity + kappa[j] / ps.density[j]) * pairGradient(p, i, j);
+				});
+
+			neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j) { change += ps.mass[j] * kappaOverDensity * pairGradient(p, i, j); });
+
+			velocity[i] -= (*dt) * change;
+			stiffness[i] += kappa[i];
+		});
+}
+
+//Writes the solver columns of the current data file row, the same columns as PressureSolver
+void DivergenceFreeSolver::writeStatistics(float densityErrorAvg)
+{
+	size_t selected = up::parallelMin(particles->size(), SIZE_MAX, [this](size_t i) { return particles->theOne[i] ? i : SIZE_MAX; });
+	float predictedVelocity = selected != SIZE_MAX ? particles->predictedVelocity[selected].length() : 0.f;
+	float velocity = selected != SIZE_MAX ? particles->velocity[selected].length() : 0.f;
+
+	*simDataFile << "," << numIterations << "," << densityErrorAvg << "," << predictedDensityErrorAvg <<
+		"," << predictedVelocity << "," << velocity << "," << numDivergenceIterations;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "helpers/neighborList.hpp"
+#include "particles/particleStore.hpp"
+#include "solvers/solverBase.hpp"
+
+#include <fstream>
+#include <vector>
+
+//Divergence-free SPH (Bender and Koschier). Two velocity solves share per particle factors
+//alpha_i = rho_i / (|sum m_j grad W_ij|^2 + sum |m_j grad W_ij|^2), computed once per step:
+//the divergence solve makes the velocity field divergence free, the density solve corrects the predicted
+//velocity until the predicted density error is below the tolerance. The corrected velocity is handed to the
+//time integration as pressure acceleration, so the rest of the step is the same as with PressureSolver.
+class DivergenceFreeSolver: public SolverBase {
+
+public:
+	DivergenceFreeSolver(ParticleStore *_particles, NeighborList *_neighbors, int *_numFluidParticles, float *_dt, std::ofstream *_simDataFile);
+	void compute() override;
+
+	//numIterations counts the density solve iterations
+	int numDivergenceIterations = 0;
+
+private:
+	static constexpr int MIN_DENSITY_ITERATIONS = 2;
+	static constexpr int MIN_DIVERGENCE_ITERATIONS = 1;
+	static constexpr int MAX_ITERATIONS = 100;
+	static constexpr float MAX_DENSITY_ERROR = 0.001f;
+	static constexpr float MAX_DIVERGENCE_ERROR = 0.001f;
+
+	int *numFluidParticles;
+	float *dt;
+	std::ofstream *simDataFile;
+	ParticleStore *particles;
+	NeighborList *neighbors;
+
+	float predictedDensityErrorAvg = 0.f;
+	std::vector<float> alpha;
+	std::vector<float> kappa;
+	std::vector<float> stiffness;
+
+	//Kernel gradient of pair p between particle i and its neighbor j, read from the pair cache when enabled
+	up::Vec2 pairGradient(size_t p, size_t i, size_t j) const
+	{
+		if (neighbors->hasPairCache) return neighbors->kernelGradients[p];
+
+		up::Vec2 distanceVector = particles->position[i] - particles->position[j];
+		return neighbors->inSupport(distanceVector) ? kernelGradient(distanceVector) : up::Vec2(0.f, 0.f);
+	}
+
+	void computeAlpha();
+	float densityChangeRate(size_t i, const std::vector<up::Vec2> &velocity) const;
+	float correctDivergenceError();
+	float correctDensityError();
+	void applyKappa(std::vector<up::Vec2> &velocity);
+	void writeStatistics(float densityErrorAvg);
+};
@@ -1,218 +1,431 @@
 #include "neightborSearch.hpp"
 
+#include "helpers/parallel.hpp"
+
 #include <algorithm>
 #include <iostream>
+#include <numeric>
 
-struct cellGridIndexSort
+NeighborSearch::NeighborSearch(ParticleStore * _particles, NeighborList * _neighbors)
 {
-	inline bool operator() (const std::shared_ptr<Particle> &i, const std::shared_ptr<Particle> &j)
-	{
-		return (i->gridCellIndex < j->gridCellIndex);
-	}
-};
+	particles = _particles;
+	neighbors = _neighbors;
+}
 
-NeighborSearch::NeighborSearch(std::string curveName, std::vector<std::shared_ptr<Particle>> * _particles)
+std::shared_ptr<NeighborSearch> NeighborSearch::create(const std::string &curveName, ParticleStore *_particles, NeighborList *_neighbors)
 {
-	SPACE_FILLING_CURVE = curveName;
-	particles = _particles;
+	if (curveName == up::curve::RowMajor::NAME) return std::make_shared<CurveNeighborSearch<up::curve::RowMajor>>(_particles, _neighbors);
+	if (curveName == up::curve::Morton::NAME) return std::make_shared<CurveNeighborSearch<up::curve::Morton>>(_particles, _neighbors);
+	if (curveName == up::curve::Hilbert::NAME) return std::make_shared<CurveNeighborSearch<up::curve::Hilbert>>(_particles, _neighbors);
+
+	return nullptr;
+}
+
+bool NeighborSearch::parseCellLookup(const std::string &lookupName, CellLookup &lookup)
+{
+	if (lookupName == "hashed") lookup = CellLookup::Hashed;
+	else if (lookupName == "linear") lookup = CellLookup::LinearScan;
+	else if (lookupName == "ranges") lookup = CellLookup::MergedRanges;
+	else return false;
+
+	return true;
 }
 
 void NeighborSearch::compute() {
-	compressedNeighborSearchInit();
-	compressedNeighborSearch();
+	if (listFree)
+	{
+		cellSize = KERNEL_SUPPORT;
+
+		compressedNeighborSearchInit();
+		cellPairSearch();
+		return;
+	}
+
+	if (needsRebuild())
+	{
+		cellSize = KERNEL_SUPPORT + std::max(skin, 0.f);
+
+		compressedNeighborSearchInit();
+		compressedNeighborSearch();
+
+		NeighborList &list = *neighbors;
+		list.hasSkin = skin > 0.f;
+		list.support = KERNEL_SUPPORT;
+
+		buildPositions = particles->position;
+		rebuildCount++;
+	}
+}
+
+//A list without skin is only valid for the positions it was built from. With a skin it stays valid
+//while no particle has moved more than skin / 2, two particles then approach by less than the skin.
+bool NeighborSearch::needsRebuild() const
+{
+	const ParticleStore &ps = *particles;
+
+	if (skin <= 0.f || neighbors->isCellPairs || !neighbors->hasSkin || neighbors->isSymmetric != symmetric || buildPositions.size() != ps.size()) return true;
+
+	float maxDisplacement = std::transform_reduce(
+		std::execution::par,
+		up::IndexIterator(0),
+		up::IndexIterator(ps.size()),
+		0.f,
+		[](float a, float b) { return std::max(a, b); },
+		[this, &ps](size_t i) { return (ps.position[i] - buildPositions[i]).length(); });
+
+	return maxDisplacement > skin / 2;
 }
 
 void NeighborSearch::compressedNeighborSearchInit()
 {
+	ParticleStore &ps = *particles;
+
 	compactCellArray.clear();
 
-	std::for_each(
-		std::execution::par,
-		particles->begin(),
-		particles->end(),
-		[this](auto&& p)
+	fitGrid();
+	computeCellKeys();
+
+	sortParticles();
+
+	//Generate and fill the compact cell array. A cell starts wherever the key changes,
+	//scanning the start flags gives every cell its slot in the array.
+	const std::vector<uint64_t> &keys = radixSorter.sortedKeys();
+	size_t numParticles = ps.size();
+
+	cellStarts.resize(numParticles);
+
+	up::parallelFor(
+		numParticles,
+		[this, &keys](size_t i) { cellStarts[i] = (i == 0 || keys[i] != keys[i - 1]) ? 1 : 0; });
+
+	std::inclusive_scan(std::execution::par, cellStarts.begin(), cellStarts.end(), cellStarts.begin());
+
+	compactCellArray.resize(numParticles > 0 ? cellStarts[numParticles - 1] : 0);
+
+	up::parallelFor(
+		numParticles,
+		[this, &keys](size_t i)
 		{
-			//Compute grid cell coordinate (k, l)
-			int gridCellCoordinateX = (int)floor((p->position_current.x - minPosX) / KERNEL_SUPPORT);
-			int gridCellCoordinateY = (int)floor((p->position_current.y - minPosY) / KERNEL_SUPPORT);
+			if (i == 0 || keys[i] != keys[i - 1]) {
+				compactCellArray[cellStarts[i] - 1] = { i, keys[i] };
+			}
+		});
+}
+
+//Sorts the particles by grid cell index. The data itself is only moved when a reorder is due,
+//otherwise sortOrder maps positions along the curve to the particles' current memory slots.
+void NeighborSearch::sortParticles()
+{
+	ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	radixSorter.sort(ps.gridCellIndex, sortOrder);
+
+	//Count the places where the next particle along the curve is not the next one in memory
+	orderBreaks.resize(numParticles);
+
+	up::parallelFor(
+		numParticles,
+		[this](size_t i) { orderBreaks[i] = (i > 0 && sortOrder[i] != sortOrder[i - 1] + 1) ? 1 : 0; });
 
-			//Compute and store grid cell z-index
-			std::bitset<8> indexXValue = std::bitset<8>(gridCellCoordinateX);
-			std::bitset<8> indexYValue = std::bitset<8>(gridCellCoordinateY);
+	size_t breaks = std::reduce(std::execution::par, orderBreaks.begin(), orderBreaks.end(), (size_t)0);
+	disorder = numParticles > 1 ? (float)breaks / (float)(numParticles - 1) : 0.f;
 
-			//XYZ curve
-			if (SPACE_FILLING_CURVE == "XYZ") p->gridCellIndex = gridCellCoordinateX + gridCellCoordinateY * (int)CELLS_IN_X;
+	searchesSinceReorder++;
 
-			//Morton Z Space Filling curve
-			if (SPACE_FILLING_CURVE == "ZIndex") p->gridCellIndex = toGridCellIndex(indexXValue, indexYValue);
+	bool intervalReached = reorderInterval > 0 && searchesSinceReorder >= reorderInterval;
+	bool localityDegraded = reorderThreshold > 0.f && disorder > reorderThreshold;
 
-			//Hilbert curve
-			if (SPACE_FILLING_CURVE == "HILBERT") p->gridCellIndex = xy2d(HILBER_CURVE_LEVEL, (int)(p->position_current.x - minPosX), (int)(p->position_current.y - minPosY));
+	if (!intervalReached && !localityDegraded) return;
+
+	ps.permute(sortOrder, permuteScratch);
+	std::iota(sortOrder.begin(), sortOrder.end(), 0);
+
+	disorder = 0.f;
+	searchesSinceReorder = 0;
+	reorderCount++;
+}
+
+//Index the compact cells by key so stencil lookups do not scan the whole array
+void NeighborSearch::indexCompactCells()
+{
+	if (cellLookup != CellLookup::Hashed) return;
+
+	cellTable.reset(compactCellArray.size());
+
+	up::parallelFor(
+		compactCellArray.size(),
+		[this](size_t cell) { cellTable.insert((uint64_t)compactCellArray[cell].cell, (uint32_t)cell); });
+}
+
+//Stores what the list-free loops walk instead of rows: the stencil ranges of every compact cell,
+//the cell of every particle and the sorted order. Rows and pair cache of earlier builds are released.
+void NeighborSearch::cellPairSearch()
+{
+	NeighborList &list = *neighbors;
+	size_t numParticles = particles->size();
+
+	indexCompactCells();
+
+	list.cellRanges.resize(compactCellArray.size() * NeighborList::MAX_CELL_RANGES);
+	list.cellRangeCounts.resize(compactCellArray.size());
+	list.particleCells.resize(numParticles);
+
+	gatherCellRanges();
+
+	up::parallelFor(
+		compactCellArray.size(),
+		[this, &list](size_t cell)
+		{
+			ParticleRange range = cellRange(cell);
 
+			for (uint32_t position = range.first; position < range.last; position++) list.particleCells[sortOrder[position]] = (uint32_t)cell;
 		});
 
-	//Sort particles by grid cell index
-	std::sort(particles->begin(), particles->end(), cellGridIndexSort());
+	list.sortedParticles = sortOrder;
+	list.support = KERNEL_SUPPORT;
+	list.hasSkin = false;
+	list.isSymmetric = false;
+	list.isCellPairs = true;
+
+	list.offsets = { 0 };
+	list.boundaryOffsets = {};
+	list.indices = {};
+	list.mirror = {};
+	list.kernelValues = {};
+	list.kernelGradients = {};
+	list.hasPairCache = false;
+
+	buildPositions = {};
+}
+
+void NeighborSearch::compressedNeighborSearch() {
+	NeighborList &list = *neighbors;
+
+	size_t numParticles = particles->size();
 
-	//Generate and fill the compact cell array
-	int marker = 0;
-	int scan = 0;
-	int currentCell = -1;
+	indexCompactCells();
 
-	for (size_t i = 0; i < particles->size(); ++i)
+	//Gather the neighbors of blocks of consecutive compact cells into chunk local buffers
+	chunks.resize((compactCellArray.size() + CELLS_PER_CHUNK - 1) / CELLS_PER_CHUNK);
+	neighborCounts.resize(numParticles);
+	if (symmetric) halfRowLengths.resize(numParticles);
+	list.boundaryOffsets.resize(numParticles);
+
+	for (size_t c = 0; c < chunks.size(); c++)
 	{
-		std::shared_ptr<Particle> &p = particles->at(i);
-		p->neighbors.clear();
-		p->neighborsBoundary.clear();
+		size_t lastCell = (c + 1) * CELLS_PER_CHUNK;
 
-		if (currentCell != p->gridCellIndex) {
-			marker = 1;
-			scan++;
+		chunks[c].firstPosition = compactCellArray[c * CELLS_PER_CHUNK].particle;
+		chunks[c].lastPosition = lastCell < compactCellArray.size() ? compactCellArray[lastCell].particle : numParticles;
+	}
 
-			CompactCell newCompactCell = {
-				i,
-				p->gridCellIndex
-			};
+	up::parallelFor(chunks.size(), [this](size_t c) { gatherChunk(c); });
 
-			compactCellArray.push_back(newCompactCell);
-		}
+	list.isSymmetric = symmetric;
+	list.clearCellPairs();
 
-		currentCell = p->gridCellIndex;
-		marker = 0;
+	if (symmetric) {
+		mergeHalfRows();
+		return;
 	}
+
+	//Chunks hold their rows in curve order, right after a reorder they are consecutive in the list as well
+	list.mirror = {};
+	mergeNeighborChunks(chunks, sortOrder, neighborCounts, list);
 }
 
-void NeighborSearch::compressedNeighborSearch() {
-	//Neighbor search
-	//6: For each cell in the compact cell array
-	for (size_t i = 0; i < compactCellArray.size(); i++)
+//Expands the half rows of the chunks into full rows: every pair (k, l) is stored in the row of k and the row of l,
+//the particle itself only once.
+//Slots are claimed with atomic cursors, sorting every row section afterwards makes the result independent of
+//the claim order, and the mirror of every pair is then found by a binary search in the neighbor's row.
+void NeighborSearch::mergeHalfRows()
+{
+	const ParticleStore &ps = *particles;
+	NeighborList &list = *neighbors;
+	size_t numParticles = ps.size();
+
+	if (cursorCapacity < numParticles) {
+		cursorCapacity = numParticles;
+		fluidCursors.reset(new std::atomic<uint32_t>[cursorCapacity]);
+		boundaryCursors.reset(new std::atomic<uint32_t>[cursorCapacity]);
+	}
+
+	up::parallelFor(
+		numParticles,
+		[this](size_t k)
+		{
+			fluidCursors[k].store(0, std::memory_order_relaxed);
+			boundaryCursors[k].store(0, std::memory_order_relaxed);
+		});
+
+	//Calls f(k, l) for every pair found by the chunk
+	auto forEachPair = [this](const NeighborChunk &chunk, auto f)
 	{
-		CompactCell currentCell = compactCellArray[i];
-		int cellIndex = currentCell.cell;
+		const uint32_t *entry = chunk.indices.data();
 
-		up::Vec2 cellIndexCartesian;
+		for (size_t position = chunk.firstPosition; position < chunk.lastPosition; position++)
+		{
+			uint32_t k = sortOrder[position];
+
+			for (uint32_t e = 0; e < halfRowLengths[k]; e++) f(k, entry[e]);
 
-		//XYZ curve
-		if (SPACE_FILLING_CURVE == "XYZ") cellIndexCartesian = { (float)(cellIndex % (int) CELLS_IN_X), floor(cellIndex / CELLS_IN_X) };
-		//Morton z space filling curve
-		if (SPACE_FILLING_CURVE == "ZIndex") cellIndexCartesian = toCartesianCoordinates(cellIndex);
-		//Hilbert curve
-		if (SPACE_FILLING_CURVE == "HILBERT") cellIndexCartesian = d2xy(HILBER_CURVE_LEVEL, cellIndex);
+			entry += halfRowLengths[k];
+		}
+	};
 
-		int xIndex = -1;
-		int yIndex = -1;
+	//The slot of l in the row of k, fluid neighbors first
+	auto cursor = [this, &ps](uint32_t k, uint32_t l) -> std::atomic<uint32_t>& { return ps.isBoundary[l] ? boundaryCursors[k] : fluidCursors[k]; };
 
-		//For each sub-range
-		for (int j = 1; j < 10; j++)
+	//Count the fluid and boundary neighbors of every full row
+	std::for_each(
+		std::execution::par,
+		chunks.begin(),
+		chunks.end(),
+		[&forEachPair, &cursor](const NeighborChunk &chunk)
 		{
-			int neighborCellIndex;
+			forEachPair(chunk, [&cursor](uint32_t k, uint32_t l)
+				{
+					cursor(k, l).fetch_add(1, std::memory_order_relaxed);
+					if (k != l) cursor(l, k).fetch_add(1, std::memory_order_relaxed);
+				});
+		});
 
-			if (SPACE_FILLING_CURVE == "XYZ") neighborCellIndex = ((int)cellIndexCartesian.x + xIndex) + ((int)cellIndexCartesian.y + yIndex) * (int)CELLS_IN_X;
-			if (SPACE_FILLING_CURVE == "ZIndex") neighborCellIndex = toGridCellIndex(std::bitset<8>((int)cellIndexCartesian.x + xIndex), std::bitset<8>((int)cellIndexCartesian.y + yIndex));
-			if (SPACE_FILLING_CURVE == "HILBERT") neighborCellIndex = xy2d(HILBER_CURVE_LEVEL, (int)cellIndexCartesian.x, (int)cellIndexCartesian.y);
+	up::parallelFor(
+		numParticles,
+		[this](size_t k) { neighborCounts[k] = fluidCursors[k].load(std::memory_order_relaxed) + boundaryCursors[k].load(std::memory_order_relaxed); });
 
-			auto iterator = std::find_if(compactCellArray.begin(), compactCellArray.end(), [&](CompactCell& c) { return c.cell == neighborCellIndex; });
-			
-			if (iterator != compactCellArray.end())
-			{
-				size_t index = std::distance(compactCellArray.begin(), iterator);
+	list.offsets.resize(numParticles + 1);
+	list.offsets[0] = 0;
+	std::inclusive_scan(std::execution::par, neighborCounts.begin(), neighborCounts.end(), list.offsets.begin() + 1);
 
-				int firstParticleIndex = compactCellArray[index].particle;
-				int lastParticleIndex = 0;
+	//Turn the counts into the first free slot of every row section
+	up::parallelFor(
+		numParticles,
+		[this, &list](size_t k)
+		{
+			list.boundaryOffsets[k] = list.offsets[k] + fluidCursors[k].load(std::memory_order_relaxed);
+			fluidCursors[k].store(list.offsets[k], std::memory_order_relaxed);
+			boundaryCursors[k].store(list.boundaryOffsets[k], std::memory_order_relaxed);
+		});
 
-				if (index >= compactCellArray.size() - 1) lastParticleIndex = particles->size() - 1;
-				else lastParticleIndex = compactCellArray[index + 1].particle;
+	list.indices.resize(list.offsets[numParticles]);
+	list.mirror.resize(list.offsets[numParticles]);
 
-				//For each particle k in the computed particle range
-				for (size_t k = currentCell.particle; k < particles->size(); k++)
+	std::for_each(
+		std::execution::par,
+		chunks.begin(),
+		chunks.end(),
+		[&list, &forEachPair, &cursor](const NeighborChunk &chunk)
+		{
+			forEachPair(chunk, [&list, &cursor](uint32_t k, uint32_t l)
 				{
-					std::shared_ptr<Particle> &currentParticle = particles->at(k);
-
-					if (currentParticle->gridCellIndex != cellIndex) break;
-
-					//For each particle l in the computed particle range
-					for (int l = firstParticleIndex; l < lastParticleIndex; l++)
-					{
-						std::shared_ptr<Particle> &potentialNeighborParticle = particles->at(l);
-
-						up::Vec2 neighborDistance = currentParticle->position_current - potentialNeighborParticle->position_current;
-						float distance = neighborDistance.length();
-
-						if (distance < KERNEL_SUPPORT)
-						{
-							if(currentParticle->theOne && !potentialNeighborParticle->theOne) potentialNeighborParticle->isTheOneNeighbor = true;
-
-							if (potentialNeighborParticle->isBoundary) 
-							{
-								currentParticle->neighborsBoundary.push_back(potentialNeighborParticle);
-							}
-							else {
-								currentParticle->neighbors.push_back(potentialNeighborParticle);
-							}
-						}
-						else {
-							if (currentParticle->theOne) potentialNeighborParticle->isTheOneNeighbor = false;
-						}
-					}
-				}
+					list.indices[cursor(k, l).fetch_add(1, std::memory_order_relaxed)] = l;
+					if (k != l) list.indices[cursor(l, k).fetch_add(1, std::memory_order_relaxed)] = k;
+				});
+		});
+
+	//Sort both sections of every row, then locate the mirror of every pair
+	up::parallelFor(
+		numParticles,
+		[&list](size_t k)
+		{
+			std::sort(list.indices.begin() + list.offsets[k], list.indices.begin() + list.boundaryOffsets[k]);
+			std::sort(list.indices.begin() + list.boundaryOffsets[k], list.indices.begin() + list.offsets[k + 1]);
+		});
+
+	up::parallelFor(
+		numParticles,
+		[&ps, &list](size_t k)
+		{
+			for (size_t p : list.allPairs(k))
+			{
+				IndexRange section = ps.isBoundary[k] ? list.boundary(list.indices[p]) : list.fluid(list.indices[p]);
+				list.mirror[p] = (uint32_t)(std::lower_bound(section.begin(), section.end(), (uint32_t)k) - list.indices.data());
 			}
-			xIndex++;
+		});
+}
 
-			if (j % 3) yIndex++;
-			if (yIndex > 1) yIndex = -1;
-			if (xIndex > 1) xIndex = -1;
-		}
+bool NeighborSearch::findCompactCell(uint64_t cellIndex, size_t &index) const
+{
+	if (cellLookup == CellLookup::Hashed)
+	{
+		uint32_t cell;
+		if (!cellTable.find((uint64_t)cellIndex, cell)) return false;
+
+		index = cell;
+		return true;
 	}
+
+	auto iterator = std::find_if(compactCellArray.begin(), compactCellArray.end(), [&](const CompactCell& c) { return c.cell == cellIndex; });
+
+	if (iterator == compactCellArray.end()) return false;
+
+	index = std::distance(compactCellArray.begin(), iterator);
+	return true;
 }
 
-int NeighborSearch::toGridCellIndex(std::bitset<8> indexXValue, std::bitset<8> indexYValue) {
-
-	std::bitset<16> gridCellIndexBits;
-
-	gridCellIndexBits[0] = indexXValue[0];
-	gridCellIndexBits[1] = indexYValue[0];
-	gridCellIndexBits[2] = indexXValue[1];
-	gridCellIndexBits[3] = indexYValue[1];
-	gridCellIndexBits[4] = indexXValue[2];
-	gridCellIndexBits[5] = indexYValue[2];
-	gridCellIndexBits[6] = indexXValue[3];
-	gridCellIndexBits[7] = indexYValue[3];
-	gridCellIndexBits[8] = indexXValue[4];
-	gridCellIndexBits[9] = indexYValue[4];
-	gridCellIndexBits[10] = indexXValue[5];
-	gridCellIndexBits[11] = indexYValue[5];
-	gridCellIndexBits[12] = indexXValue[6];
-	gridCellIndexBits[13] = indexYValue[6];
-	gridCellIndexBits[14] = indexXValue[7];
-	gridCellIndexBits[15] = indexYValue[7];
-
-	return (int)gridCellIndexBits.to_ulong();
+//Positions held by the compact cells with keys in the interval. Cells are sorted by key, so one binary
+//search finds the first of them and the sweep over the following cells stops after the interval's last key.
+//Keys are distinct, so the interval starts at most as many cells away from the query cell as their keys differ.
+NeighborSearch::ParticleRange NeighborSearch::findKeyRange(const up::curve::KeyInterval &interval, size_t queryCell, size_t &searchStart) const
+{
+	uint64_t queryKey = compactCellArray[queryCell].cell;
+	size_t low = searchStart;
+	size_t high = compactCellArray.size();
+
+	if (interval.first <= queryKey) {
+		high = std::min(high, queryCell + 1);
+		if (queryKey - interval.first < queryCell) low = std::max(low, (size_t)(queryCell - (queryKey - interval.first)));
+	}
+	else {
+		low = std::max(low, queryCell);
+		if (interval.first - queryKey < high - queryCell) high = queryCell + (size_t)(interval.first - queryKey);
+	}
+
+	auto first = std::lower_bound(
+		compactCellArray.begin() + low,
+		compactCellArray.begin() + std::max(low, high),
+		interval.first,
+		[](const CompactCell &c, uint64_t key) { return c.cell < key; });
+
+	auto last = first;
+	while (last != compactCellArray.end() && last->cell <= interval.last) last++;
+
+	searchStart = std::distance(compactCellArray.begin(), last);
+
+	if (first == last) return { 0, 0 };
+
+	uint32_t lastPosition = last != compactCellArray.end() ? (uint32_t)last->particle : (uint32_t)particles->size();
+	return { (uint32_t)first->particle, lastPosition };
 }
 
-up::Vec2 NeighborSearch::toCartesianCoordinates(int gridCellCoordinate)
+//Fits the grid around the bounding box of all particles, with a margin of one cell on every side
+void NeighborSearch::fitGrid()
 {
+	const ParticleStore &ps = *particles;
 
-	std::bitset<16> gridCellIndexBits = std::bitset<16>(gridCellCoordinate);
-	std::bitset<8> indexXValue;
-	std::bitset<8> indexYValue;
-
-	indexXValue[0] = gridCellIndexBits[0];
-	indexXValue[1] = gridCellIndexBits[2];
-	indexXValue[2] = gridCellIndexBits[4];
-	indexXValue[3] = gridCellIndexBits[6];
-	indexXValue[4] = gridCellIndexBits[8];
-	indexXValue[5] = gridCellIndexBits[10];
-	indexXValue[6] = gridCellIndexBits[12];
-	indexXValue[7] = gridCellIndexBits[14];
-
-	indexYValue[0] = gridCellIndexBits[1];
-	indexYValue[1] = gridCellIndexBits[3];
-	indexYValue[2] = gridCellIndexBits[5];
-	indexYValue[3] = gridCellIndexBits[7];
-	indexYValue[4] = gridCellIndexBits[9];
-	indexYValue[5] = gridCellIndexBits[11];
-	indexYValue[6] = gridCellIndexBits[13];
-	indexYValue[7] = gridCellIndexBits[15];
-
-	return up::Vec2((float)indexXValue.to_ulong(), (float)indexYValue.to_ulong());
-}
\ No newline at end of file
+	struct Bounds
+	{
+		up::Vec2 min;
+		up::Vec2 max;
+	};
+
+	Bounds bounds = std::transform_reduce(
+		std::execution::par,
+		ps.position.begin(),
+		ps.position.end(),
+		Bounds{ { INFINITY, INFINITY }, { -INFINITY, -INFINITY } },
+		[](const Bounds &a, const Bounds &b)
+		{
+			return Bounds{ { std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y) },
+				{ std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y) } };
+		},
+		[](const up::Vec2 &position) { return Bounds{ position, position }; });
+
+	if (ps.empty()) bounds = { { 0.f, 0.f }, { 0.f, 0.f } };
+
+	gridOrigin = { bounds.min.x - cellSize, bounds.min.y - cellSize };
+	grid.cellsInX = (uint32_t)((bounds.max.x - gridOrigin.x) / cellSize) + 2;
+	grid.cellsInY = (uint32_t)((bounds.max.y - gridOrigin.y) / cellSize) + 2;
+}
@@ -1,40 +1,262 @@
 #pragma once
-#include <SFML/Graphics.hpp>
 #include "helpers/compactCell.hpp"
-#include "particles/particle2.hpp"
-#include "helpers/hilbert_curve.hpp"
+#include "helpers/compactHashTable.hpp"
+#include "particles/particleStore.hpp"
+#include "helpers/neighborChunk.hpp"
+#include "helpers/neighborList.hpp"
+#include "helpers/parallel.hpp"
+#include "helpers/radixSort.hpp"
+#include "helpers/spaceFillingCurve.hpp"
 #include "solvers/solverBase.hpp"
 
-#include <bitset>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <execution>
+#include <memory>
+#include <string>
 
 class Solver;
 
+//Compact cell neighbor search: particles are sorted by the key of their grid cell along a space filling curve.
+//The curve specific loops live in CurveNeighborSearch, create() picks the instantiation once by name.
 class NeighborSearch: public SolverBase {
 
 public:
-	NeighborSearch(std::string curveName, std::vector<std::shared_ptr<Particle>> *fParticles);
+	NeighborSearch(ParticleStore *fParticles, NeighborList *fNeighbors);
 	void compute() override;
 
-private:
-	static constexpr float CELLS_IN_X = radius * 2 / KERNEL_SUPPORT;
-	static constexpr int HILBER_CURVE_LEVEL = (int)(radius / KERNEL_SUPPORT);
+	//Search along the named curve (XYZ, ZIndex or HILBERT), nullptr for unknown names
+	static std::shared_ptr<NeighborSearch> create(const std::string &curveName, ParticleStore *fParticles, NeighborList *fNeighbors);
 
+	//How the cells of a stencil are found in the compact cell array. MergedRanges merges the stencil
+	//into intervals of consecutive keys and reads each with one binary search and one sweep.
+	enum class CellLookup
+	{
+		LinearScan,
+		Hashed,
+		MergedRanges
+	};
+
+	CellLookup cellLookup = CellLookup::Hashed;
+
+	//Maps "hashed", "linear" or "ranges" to a cell lookup, returns false for unknown names
+	static bool parseCellLookup(const std::string &lookupName, CellLookup &lookup);
+
+	//Particle data is physically reordered along the curve every reorderInterval searches (0 disables),
+	//or earlier once the memory order disorder exceeds reorderThreshold (0 disables).
+	//In between, the search reads particles through the sorted index order and leaves the data in place.
+	int reorderInterval = 1;
+	float reorderThreshold = 0.f;
+
+	//Fraction of consecutive particles along the curve that are not neighbors in memory, 0 right after a reorder
+	float memoryDisorder() const { return disorder; }
+	int numReorders() const { return reorderCount; }
+
+	//Verlet lists: with a skin > 0 the lists hold every pair within KERNEL_SUPPORT + skin and are only
+	//rebuilt once some particle has moved more than skin / 2 since the last build
+	float skin = 0.f;
+
+	int numRebuilds() const { return rebuildCount; }
+
+	//Symmetric search: only half of the stencil is visited, so every pair is found and distance tested once.
+	//Both directions are stored, rows sorted by neighbor index, with mirror positions for sharing per pair values.
+	bool symmetric = false;
+
+	//List-free mode: no rows are gathered, the list only keeps the stencil ranges of every compact cell
+	//and the loops test distances on the fly. Costs extra distance tests per step, saves the rows and the pair cache.
+	bool listFree = false;
+
+protected:
 	std::vector<CompactCell> compactCellArray;
-	std::string SPACE_FILLING_CURVE;
+	CompactHashTable cellTable;
+
+	//Grid cells are as wide as the search radius, so the 3x3 stencil covers every neighbor.
+	//The grid follows the particles: its origin sits one cell below their bounding box on every build,
+	//so cell coordinates and their stencil neighbors are never negative however far the scene extends.
+	float cellSize = KERNEL_SUPPORT;
+	up::Vec2 gridOrigin;
+	up::curve::Grid grid;
+
+	using ParticleRange = PositionRange;
 
-	up::Vec2 centerPosition = { 600.0f, 350.0f };
+	using Stencil = std::array<ParticleRange, 9>;
 
-	float minPosX = centerPosition.x - radius;
-	float minPosY = centerPosition.y - radius;
-	float maxPosX = centerPosition.x + radius;
-	float maxPosY = centerPosition.y + radius;
+	//Every chunk gathers the rows of a block of consecutive compact cells
+	static constexpr size_t CELLS_PER_CHUNK = 64;
 
-	std::vector<std::shared_ptr<Particle>> *particles;
+	ParticleStore *particles;
+	NeighborList *neighbors;
+	std::vector<uint32_t> sortOrder;
+	RadixSorter<uint64_t> radixSorter;
+	ParticleStore permuteScratch;
+	std::vector<uint32_t> cellStarts;
+	std::vector<uint32_t> neighborCounts;
+	std::vector<uint32_t> halfRowLengths;
+	std::vector<NeighborChunk> chunks;
+	std::vector<uint32_t> orderBreaks;
 
-	int toGridCellIndex(std::bitset<8> indexXValue, std::bitset<8> indexYValue);
-	up::Vec2 toCartesianCoordinates(int gridCellCoordinate);
+	float disorder = 0.f;
+	int searchesSinceReorder = 0;
+	int reorderCount = 0;
 
+	std::vector<up::Vec2> buildPositions;
+	int rebuildCount = 0;
+
+	//Per row fluid and boundary slot cursors of the symmetric merge
+	std::unique_ptr<std::atomic<uint32_t>[]> fluidCursors;
+	std::unique_ptr<std::atomic<uint32_t>[]> boundaryCursors;
+	size_t cursorCapacity = 0;
+
+	//Writes the cell key of every particle to gridCellIndex
+	virtual void computeCellKeys() = 0;
+	//Collects the rows of every particle in the chunk, fluid neighbors first, and records the row lengths
+	virtual void gatherChunk(size_t chunkIndex) = 0;
+	//Writes the stencil ranges of every compact cell to the list for the list-free mode
+	virtual void gatherCellRanges() = 0;
+
+	void fitGrid();
+	bool needsRebuild() const;
+	void sortParticles();
 	void compressedNeighborSearchInit();
 	void compressedNeighborSearch();
-};
\ No newline at end of file
+	void indexCompactCells();
+	void cellPairSearch();
+	bool findCompactCell(uint64_t cellIndex, size_t &index) const;
+	ParticleRange findKeyRange(const up::curve::KeyInterval &interval, size_t queryCell, size_t &searchStart) const;
+	void mergeHalfRows();
+
+	//Range of sorted positions held by the given compact cell
+	ParticleRange cellRange(size_t cell) const
+	{
+		uint32_t last = cell + 1 < compactCellArray.size() ? (uint32_t)compactCellArray[cell + 1].particle : (uint32_t)particles->size();
+		return { (uint32_t)compactCellArray[cell].particle, last };
+	}
+};
+
+//Neighbor search specialized for one curve policy of up::curve, so key computation and
+//stencil lookups are inlined into the per particle and per cell loops
+template <typename Curve>
+class CurveNeighborSearch: public NeighborSearch {
+
+public:
+	using NeighborSearch::NeighborSearch;
+
+protected:
+	void computeCellKeys() override
+	{
+		ParticleStore &ps = *particles;
+
+		up::parallelFor(
+			ps.size(),
+			[this, &ps](size_t i)
+			{
+				//Compute grid cell coordinate (k, l), positive since the origin lies below every particle
+				uint32_t gridCellCoordinateX = (uint32_t)((ps.position[i].x - gridOrigin.x) / cellSize);
+				uint32_t gridCellCoordinateY = (uint32_t)((ps.position[i].y - gridOrigin.y) / cellSize);
+
+				ps.gridCellIndex[i] = Curve::encode(grid, gridCellCoordinateX, gridCellCoordinateY);
+			});
+	}
+
+	//Fills stencil with the particle ranges of the stencil cells from firstStencilCell on and returns how many it holds
+	size_t findStencil(size_t cell, size_t firstStencilCell, Stencil &stencil) const
+	{
+		up::curve::StencilKeys keys;
+		up::curve::StencilIntervals intervals;
+		size_t numStencilCells = keys.size() - firstStencilCell;
+
+		Curve::stencil(grid, compactCellArray[cell].cell, keys);
+
+		if (cellLookup == CellLookup::MergedRanges)
+		{
+			size_t numRanges = up::curve::planIntervals(keys.data() + firstStencilCell, numStencilCells, intervals);
+
+			//Intervals are ascending, so every search continues where the previous one stopped
+			size_t searchStart = 0;
+			for (size_t r = 0; r < numRanges; r++) stencil[r] = findKeyRange(intervals[r], cell, searchStart);
+
+			return numRanges;
+		}
+
+		for (size_t s = 0; s < numStencilCells; s++)
+		{
+			size_t index;
+			stencil[s] = findCompactCell(keys[firstStencilCell + s], index) ? cellRange(index) : ParticleRange{ 0, 0 };
+		}
+
+		return numStencilCells;
+	}
+
+	void gatherCellRanges() override
+	{
+		NeighborList &list = *neighbors;
+
+		up::parallelFor(
+			compactCellArray.size(),
+			[this, &list](size_t cell)
+			{
+				Stencil stencil;
+				size_t numRanges = findStencil(cell, 0, stencil);
+
+				std::copy(stencil.begin(), stencil.begin() + numRanges, list.cellRanges.begin() + cell * NeighborList::MAX_CELL_RANGES);
+				list.cellRangeCounts[cell] = (uint8_t)numRanges;
+			});
+	}
+
+	//Only the chunk's own particles are written, so chunks can run in parallel.
+	//The symmetric search collects half rows: the particle itself, later particles of the own cell and the cells after it in row order.
+	void gatherChunk(size_t chunkIndex) override
+	{
+		const ParticleStore &ps = *particles;
+		NeighborList &list = *neighbors;
+		NeighborChunk &chunk = chunks[chunkIndex];
+		Stencil stencil;
+
+		//Stencil keys are in row order, the cells after the own one (index 4) form the forward half
+		size_t firstStencilCell = symmetric ? 5 : 0;
+
+		float searchRadius = cellSize;
+
+		size_t firstCell = chunkIndex * CELLS_PER_CHUNK;
+		size_t lastCell = std::min(compactCellArray.size(), firstCell + CELLS_PER_CHUNK);
+
+		chunk.clear();
+
+		for (size_t cell = firstCell; cell < lastCell; cell++)
+		{
+			//Find the particle ranges of the 3x3 cells around this one
+			size_t numRanges = findStencil(cell, firstStencilCell, stencil);
+
+			ParticleRange particlesInCell = cellRange(cell);
+
+			//For each particle k in the cell
+			for (uint32_t position = particlesInCell.first; position < particlesInCell.last; position++)
+			{
+				uint32_t k = sortOrder[position];
+				chunk.beginRow();
+
+				auto visit = [&](uint32_t neighborPosition)
+				{
+					uint32_t l = sortOrder[neighborPosition];
+					up::Vec2 neighborDistance = ps.position[k] - ps.position[l];
+
+					if (neighborDistance.length() < searchRadius) chunk.add(l, ps.isBoundary[l]);
+				};
+
+				if (symmetric) {
+					for (uint32_t neighborPosition = position; neighborPosition < particlesInCell.last; neighborPosition++) visit(neighborPosition);
+				}
+
+				//For each particle l in the stencil ranges
+				for (size_t s = 0; s < numRanges; s++)
+				{
+					for (uint32_t neighborPosition = stencil[s].first; neighborPosition < stencil[s].last; neighborPosition++) visit(neighborPosition);
+				}
+
+				chunk.endRow(k, list, symmetric ? halfRowLengths : neighborCounts);
+			}
+		}
+	}
+};
@@ -1,164 +1,298 @@
 #include "pressureSolver.hpp"
 #include "solver.hpp"
+#include "helpers/parallel.hpp"
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
 #include <execution>
 
-PressureSolver::PressureSolver(std::vector<std::shared_ptr<Particle>> *_particles, int  *_numFluidParticles, float *_dt, std::ofstream *_simDataFile)
+PressureSolver::PressureSolver(ParticleStore *_particles, NeighborList *_neighbors, int  *_numFluidParticles, float *_dt, std::ofstream *_simDataFile)
 {
 	particles = _particles;
+	neighbors = _neighbors;
 	numFluidParticles = _numFluidParticles;
 	dt = _dt;
 	simDataFile = _simDataFile;
 }
 
 void PressureSolver::compute() {
-	
-	float predictedDensityErrorAvg = 0.f;
-
-	//Initialization
-	std::for_each(
-		std::execution::par,
-		particles->begin(),
-		particles->end(),
-		[this, &predictedDensityErrorAvg](auto&& p)
-		{
-			if (p->isBoundary) return;
-			
-			float sourceTerm = computeSourceTerm(p);
-			float diagonalElement = computeDiagonal(p);
-
-			p->predictedDensityError = sourceTerm;
-			p->diagonalElement = diagonalElement;
-			p->pressure = 0.f;
 
-			predictedDensityErrorAvg += sourceTerm;
-		});
+	initialize();
 
-	
 	//Iteration l
 	float densityErrorAvg = INFINITY;
-	up::Vec2 currentParticlePredictedVelocity;
-	up::Vec2 currentParticleVelocity;
 
 	numIterations = 0;
-	
-	/*
-	std::for_each(
-		std::execution::par,
-		particles->begin(),
-		particles->end(),
-		[this, &densityErrorAvg, &predictedDensityErrorAvg](auto&& p)
-		{
-			if (p->isBoundary) return;
 
-			up::Vec2 fpressure(0.f, 0.f);
+	if (activeSet) densityErrorAvg = solveActiveSet();
 
-			for (auto &pj : p->neighbors)
-			{
-				up::Vec2 distanceVector = p->position_current - pj->position_current;
+	//Set min densityErrorAvg to break loop
+	//Define min number of iterations	
+	while (densityErrorAvg > MAX_DENSITY_ERROR || numIterations < MIN_ITERATIONS) 
+	{
+		densityErrorAvg = iterate();
+		numIterations++;
+	}
+
+	writeStatistics(densityErrorAvg);
+}
+
+//Writes the solver columns of the current data file row. The velocities are the ones of the selected
+//particle with the lowest index, so the row does not depend on which thread saw it last. There is no divergence solve.
+void PressureSolver::writeStatistics(float densityErrorAvg)
+{
+	size_t selected = up::parallelMin(particles->size(), SIZE_MAX, [this](size_t i) { return particles->theOne[i] ? i : SIZE_MAX; });
+
+	if (selected != SIZE_MAX) {
+		currentParticlePredictedVelocity = particles->predictedVelocity[selected];
+		currentParticleVelocity = particles->velocity[selected];
+	}
+
+	*simDataFile << "," << numIterations << "," << densityErrorAvg 	<< "," << predictedDensityErrorAvg << 
+		"," << currentParticlePredictedVelocity.length() << "," << currentParticleVelocity.length() << "," << 0;
+}
+
+//Computes source term and diagonal element and resets the pressure of every fluid particle,
+//to zero or to the warm start guess from the previous step. The fused init kernel has already written
+//source term and diagonal, then they are only read.
+void PressureSolver::initialize() {
 
-				// Compute pressure force contribution
-				fpressure -= (p->pressure / pow(p->density, 2) + pj->pressure / pow(pj->density, 2)) * kernelGradient(distanceVector);
+	float warmStartScale = 0.f;
+
+	if (warmStart == WarmStart::Previous) warmStartScale = 1.f;
+	else if (warmStart == WarmStart::DtScaled) warmStartScale = previousDt > 0.f ? (previousDt / *dt) * (previousDt / *dt) : 1.f;
+
+	previousDt = *dt;
+
+	float sourceTermSum = up::parallelSum<float>(
+		particles->size(),
+		[this, warmStartScale](size_t i)
+		{
+			if (particles->isBoundary[i]) return 0.f;
+
+			if (!fusedInitialization) {
+				particles->predictedDensityError[i] = computeSourceTerm(i);
+				particles->diagonalElement[i] = computeDiagonal(i);
 			}
 
-			for (auto &pj : p->neighborsBoundary)
-			{
-				up::Vec2 distanceVector = p->position_current - pj->position_current;
+			float sourceTerm = particles->predictedDensityError[i];
+			particles->pressure[i] = warmStart == WarmStart::Off ? 0.f : warmStartScale * particles->pressure[i];
+
+			return sourceTerm;
+		});
+
+	predictedDensityErrorAvg = sourceTermSum / *numFluidParticles;
+}
+
+//Runs one relaxed Jacobi iteration and returns the average density error
+float PressureSolver::iterate() {
 
-				// Compute pressure force contribution
-				fpressure -= (p->pressure / pow(p->density, 2) + pj->pressure / pow(pj->density, 2)) * kernelGradient(distanceVector);
+	//First loop
+	computePressureAccelerations(particles->pressure);
+
+	//Second loop
+	float densityErrorAvg = up::parallelSum<float>(
+		particles->size(),
+		[this](size_t i)
+		{
+			particles->negVelocityDivergence[i] = computeDivergence(i);
+
+			if (particles->diagonalElement[i] != 0) {
+				updatePressure(i);
 			}
 
-			p->pressureAcceleration = fpressure;
+			return std::max(particles->negVelocityDivergence[i] - particles->predictedDensityError[i], 0.f);
 		});
-	*/
-	
-	//Set min densityErrorAvg to break loop
-	//Define min number of iterations	
-	while (densityErrorAvg > 0.001f || numIterations < MIN_ITERATIONS) 
+
+	//Divide by rest density of fluid to normalize the change of volume
+	densityErrorAvg /= PARTICLE_REST_DENSITY;
+	densityErrorAvg /= *numFluidParticles;
+
+	return densityErrorAvg;
+}
+
+//After ACTIVE_AFTER_ITERATIONS full iterations, every full iteration is followed by up to MAX_ACTIVE_ITERATIONS
+//iterations on the particles it left unconverged, until a full iteration meets the error criterion.
+//Returns the error of that last full iteration.
+float PressureSolver::solveActiveSet()
+{
+	float densityErrorAvg = INFINITY;
+
+	while (true)
 	{
-		densityErrorAvg = 0.f;
-
-		//First loop
-		std::for_each(
-			std::execution::par,
-			particles->begin(),
-			particles->end(),
-			[this](auto&& p)
-			{
-				if (p->isBoundary) return;
+		densityErrorAvg = iterate();
+		numIterations++;
 
-				p->pressureAcceleration = computePressureAcceleration(p);
-			});
+		if (densityErrorAvg <= MAX_DENSITY_ERROR && numIterations >= MIN_ITERATIONS) break;
+		if (numIterations < ACTIVE_AFTER_ITERATIONS) continue;
 
-		//Second loop
-		std::for_each(
-			std::execution::par,
-			particles->begin(),
-			particles->end(),
-			[this, &densityErrorAvg, &currentParticlePredictedVelocity, &currentParticleVelocity](auto&& p)
-			{
-				p->negVelocityDivergence = computeDivergence(p);
+		collectUpdateSet();
 
-				if (p->diagonalElement != 0) {
-					updatePressure(p);
-				}
+		//The estimate counts the last known error of the particles outside the set, the next full iteration checks it
+		for (int iteration = 0; iteration < MAX_ACTIVE_ITERATIONS && !updateSet.empty(); iteration++)
+		{
+			float estimatedErrorAvg = iterateActiveSet();
+			numIterations++;
 
-				float predictedDensityError = std::max(p->negVelocityDivergence - p->predictedDensityError, 0.f);
+			if (estimatedErrorAvg <= MAX_DENSITY_ERROR && numIterations >= MIN_ITERATIONS) break;
+		}
+	}
 
-				densityErrorAvg += predictedDensityError;
+	return densityErrorAvg;
+}
 
-				if (p->theOne) {
-					currentParticlePredictedVelocity = p->predictedVelocity;
-					currentParticleVelocity = p->velocity;				}
-			});
+//One Jacobi iteration restricted to the update set. Only these pressures change, so only the accelerations of the
+//set and its neighbors do. Particles whose residual dropped below tolerance leave the set.
+float PressureSolver::iterateActiveSet()
+{
+	ParticleStore &ps = *particles;
 
-		//Divide by rest density of fluid to normalize the change of volume
-		densityErrorAvg /= PARTICLE_REST_DENSITY;
-		densityErrorAvg /= *numFluidParticles;
-		predictedDensityErrorAvg /= *numFluidParticles;
-		numIterations++;
+	gatherAccelerationSet();
+
+	up::parallelFor(
+		accelerationSet.size(),
+		[this, &ps](size_t k)
+		{
+			uint32_t i = accelerationSet[k];
+			ps.pressureAcceleration[i] = computePressureAcceleration(i, ps.pressure);
+		});
+
+	float errorSum = up::parallelSum<float>(
+		updateSet.size(),
+		[this, &ps](size_t k)
+		{
+			uint32_t i = updateSet[k];
+			ps.negVelocityDivergence[i] = computeDivergence(i);
+
+			if (ps.diagonalElement[i] != 0) {
+				updatePressure(i);
+			}
+
+			return std::max(ps.negVelocityDivergence[i] - ps.predictedDensityError[i], 0.f);
+		});
+
+	float estimatedErrorAvg = (frozenErrorSum + errorSum) / PARTICLE_REST_DENSITY / *numFluidParticles;
+
+	frozenErrorSum += up::parallelSum<float>(
+		updateSet.size(),
+		[this, &ps](size_t k)
+		{
+			uint32_t i = updateSet[k];
+			return isUnconverged(i) ? 0.f : std::max(ps.negVelocityDivergence[i] - ps.predictedDensityError[i], 0.f);
+		});
+
+	compactScratch.resize(updateSet.size());
+	auto last = std::copy_if(std::execution::par, updateSet.begin(), updateSet.end(), compactScratch.begin(), [this](uint32_t i) { return isUnconverged(i); });
+	compactScratch.resize(last - compactScratch.begin());
+	updateSet.swap(compactScratch);
+
+	return estimatedErrorAvg;
+}
+
+//Whether the last Jacobi update of particle i still moved its pressure by more than the tolerance allows:
+//too little pressure, or too much while the pressure is not yet clamped at zero
+bool PressureSolver::isUnconverged(size_t i) const
+{
+	const ParticleStore &ps = *particles;
+
+	if (ps.isBoundary[i] || ps.diagonalElement[i] == 0) return false;
+
+	float residual = ps.predictedDensityError[i] - ps.negVelocityDivergence[i];
+
+	return residual < -ACTIVE_RESIDUAL || (residual > ACTIVE_RESIDUAL && ps.pressure[i] > 0.f);
+}
+
+//Starts the update set from the residuals of the last full iteration
+void PressureSolver::collectUpdateSet()
+{
+	const ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	updateSet.resize(numParticles);
+	auto last = std::copy_if(std::execution::par, up::IndexIterator(0), up::IndexIterator(numParticles), updateSet.begin(), [this](size_t i) { return isUnconverged(i); });
+	updateSet.resize(last - updateSet.begin());
+
+	frozenErrorSum = up::parallelSum<float>(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i] || isUnconverged(i)) return 0.f;
+			return std::max(ps.negVelocityDivergence[i] - ps.predictedDensityError[i], 0.f);
+		});
+}
+
+//The update set and its fluid neighbors, each once. The order depends on the threads, the accelerations do not.
+void PressureSolver::gatherAccelerationSet()
+{
+	const ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	if (stampCapacity < numParticles) {
+		gatherStamps = std::make_unique<std::atomic<uint32_t>[]>(numParticles);
+		stampCapacity = numParticles;
+		gatherStamp = 0;
+
+		for (size_t i = 0; i < numParticles; i++) gatherStamps[i].store(0, std::memory_order_relaxed);
 	}
-	
 
-	*simDataFile << "," << numIterations << "," << densityErrorAvg 	<< "," << predictedDensityErrorAvg << 
-		"," << currentParticlePredictedVelocity.length() << "," << currentParticleVelocity.length();
+	//A new stamp marks every particle as not gathered, zero stays reserved for fresh stamps
+	if (++gatherStamp == 0) {
+		for (size_t i = 0; i < stampCapacity; i++) gatherStamps[i].store(0, std::memory_order_relaxed);
+		gatherStamp = 1;
+	}
+
+	accelerationSet.resize(numParticles);
+	std::atomic<uint32_t> count{ 0 };
+
+	up::parallelFor(
+		updateSet.size(),
+		[this, &ps, &count](size_t k)
+		{
+			auto gather = [this, &count](uint32_t i)
+			{
+				if (gatherStamps[i].exchange(gatherStamp, std::memory_order_relaxed) != gatherStamp) accelerationSet[count.fetch_add(1, std::memory_order_relaxed)] = i;
+			};
+
+			uint32_t i = updateSet[k];
+
+			gather(i);
+			neighbors->forEachFluid(i, ps, [&gather](size_t, uint32_t j) { gather(j); });
+		});
+
+	accelerationSet.resize(count.load());
 }
 
 //Check boundary contribution
 //Matrix vector product should converge to the source term
-float PressureSolver::computeSourceTerm(std::shared_ptr<Particle> pi) {
+float PressureSolver::computeSourceTerm(size_t i) {
+	const ParticleStore &ps = *particles;
 	float summedTerm1 = 0.f;
 	float summedTerm2 = 0.f;
 	float sourceTerm = 0.f;
 
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVector = pi->position_current - pj->position_current;
-		up::Vec2 gradient = kernelGradient(distanceVector);
-		up::Vec2 velocityDiff = pi->predictedVelocity - pj->predictedVelocity;
-		summedTerm1 += pj->mass * (velocityDiff).dot(gradient);
-	}
-
-	for (auto &pj : pi->neighborsBoundary)
-	{
-		up::Vec2 boundaryNextVel = pi->velocity; //Boundary velocity at t + 1
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradient = pairGradient(p, i, j);
+			up::Vec2 velocityDiff = ps.predictedVelocity[i] - ps.predictedVelocity[j];
+			summedTerm1 += ps.mass[j] * (velocityDiff).dot(gradient);
+		});
 
-		up::Vec2 distanceVector = pi->position_current - pj->position_current;
-		up::Vec2 gradient = kernelGradient(distanceVector);
-		summedTerm2 += pj->mass * (pi->predictedVelocity - pj->velocity).dot(gradient);
-	}
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradient = pairGradient(p, i, j);
+			summedTerm2 += ps.mass[j] * (ps.predictedVelocity[i] - ps.velocity[j]).dot(gradient);
+		});
 
-	sourceTerm = PARTICLE_REST_DENSITY - pi->density - (*dt) * summedTerm1 - (*dt) * summedTerm2;
+	sourceTerm = PARTICLE_REST_DENSITY - ps.density[i] - (*dt) * summedTerm1 - (*dt) * summedTerm2;
 
 	return sourceTerm;
 }
 
 //Check boundary contribution
 //Play around with gamma
-float PressureSolver::computeDiagonal(std::shared_ptr<Particle> pi)
+float PressureSolver::computeDiagonal(size_t i)
 {
+	const ParticleStore &ps = *particles;
 	float diagonalElement;
 	up::Vec2 summedTerm1 = { 0.f, 0.f };
 	up::Vec2 summedTerm2 = { 0.f, 0.f };
@@ -167,107 +301,187 @@ float PressureSolver::computeDiagonal(std::shared_ptr<Particle> pi)
 	float summedTerm5 = 0.f;
 
 	//Summed term 1
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedTerm1 += (pj->mass / restDensitySquared) * gradientij;
-	}
+			summedTerm1 += (ps.mass[j] / restDensitySquared) * gradientij;
+		});
 
 	//Summed term 2
-	for (auto &pj : pi->neighborsBoundary)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedTerm2 += (pj->mass / restDensitySquared) * gradientij;
-	}
+			summedTerm2 += (ps.mass[j] / restDensitySquared) * gradientij;
+		});
 
 	//Summed term 3
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedTerm3 += pj->mass * ((-1 * summedTerm1 - (2 * gamma * summedTerm2))).dot(gradientij);
-	}
+			summedTerm3 += ps.mass[j] * ((-1 * summedTerm1 - (2 * gamma * summedTerm2))).dot(gradientij);
+		});
 
 	//Summed term 4
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 distanceVectorji = pj->position_current - pi->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
-		up::Vec2 gradientji = kernelGradient(distanceVectorji);
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
+			//The kernel gradient is antisymmetric
+			up::Vec2 gradientji = -1 * gradientij;
 
-		summedTerm4 += pj->mass * (((pi->mass / restDensitySquared) * gradientji)).dot(gradientij);
-	}
+			summedTerm4 += ps.mass[j] * (((ps.mass[i] / restDensitySquared) * gradientji)).dot(gradientij);
+		});
 
 	//Summed term 5
-	for (auto &pj : pi->neighborsBoundary)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedTerm5 += pj->mass * ((-1 * summedTerm1 - (2 * gamma * summedTerm2))).dot(gradientij);
-	}
+			summedTerm5 += ps.mass[j] * ((-1 * summedTerm1 - (2 * gamma * summedTerm2))).dot(gradientij);
+		});
 
 	diagonalElement = (*dt) * (*dt) * (summedTerm3 + summedTerm4 + summedTerm5);
 
 	return diagonalElement;
 }
 
-up::Vec2 PressureSolver::computePressureAcceleration(std::shared_ptr<Particle> pi) 
+//The diagonal of computeDiagonal() from sums over a single neighbor sweep. Terms 3 and 5 are linear in the
+//neighbor gradients and term 4 only needs their squared lengths, so fluidGradientSum = sum m_j grad W_ij,
+//boundaryGradientSum = sum m_b grad W_ib and fluidGradientSquaredSum = sum m_j |grad W_ij|^2 determine it.
+float PressureSolver::diagonalFromSums(size_t i, up::Vec2 fluidGradientSum, up::Vec2 boundaryGradientSum, float fluidGradientSquaredSum) const
+{
+	up::Vec2 summedTerm1 = fluidGradientSum / restDensitySquared;
+	up::Vec2 summedTerm2 = boundaryGradientSum / restDensitySquared;
+	up::Vec2 displacement = -1 * summedTerm1 - (2 * gamma * summedTerm2);
+
+	float summedTerm3 = displacement.dot(fluidGradientSum);
+	float summedTerm4 = -(particles->mass[i] / restDensitySquared) * fluidGradientSquaredSum;
+	float summedTerm5 = displacement.dot(boundaryGradientSum);
+
+	return (*dt) * (*dt) * (summedTerm3 + summedTerm4 + summedTerm5);
+}
+
+//Pressure acceleration of particle i for the given pressure field
+up::Vec2 PressureSolver::computePressureAcceleration(size_t i, const std::vector<float> &pressure) 
 {
+	const ParticleStore &ps = *particles;
 	up::Vec2 summedAcceleration = { 0.f, 0.f };
 	up::Vec2 summedTerm1 = { 0.f, 0.f };
 	up::Vec2 summedTerm2 = { 0.f, 0.f };
 
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
-		//Note: Adjust in case rest densities are different
-		summedTerm1 += pj->mass * ((pi->pressure + pj->pressure) / restDensitySquared) * gradientij;
-	}
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
+			//Note: Adjust in case rest densities are different
+			summedTerm1 += ps.mass[j] * ((pressure[i] + pressure[j]) / restDensitySquared) * gradientij;
+		});
 
-	for (auto &pj : pi->neighborsBoundary)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
-
-		summedTerm2 += pj->mass * 2 * (pi->pressure / restDensitySquared) * gradientij;
-	}
+	summedTerm2 = computeBoundaryPressureTerm(i, pressure);
 
 	summedAcceleration = -1 * summedTerm1 - (gamma * summedTerm2);
 
 	return summedAcceleration;
 }
 
+//Boundary part of the pressure acceleration of particle i, before the factor gamma
+up::Vec2 PressureSolver::computeBoundaryPressureTerm(size_t i, const std::vector<float> &pressure)
+{
+	const ParticleStore &ps = *particles;
+	up::Vec2 summedTerm2 = { 0.f, 0.f };
+
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
+
+			summedTerm2 += ps.mass[j] * 2 * (pressure[i] / restDensitySquared) * gradientij;
+		});
+
+	return summedTerm2;
+}
+
+//Pressure accelerations of all fluid particles for the given pressure field. On a symmetric list the fluid term
+//(p_i + p_j) grad W_ij is antisymmetric, so the owner of every pair computes it once and writes both directions,
+//then every particle sums its row. Boundary pairs only act on the fluid particle and are summed as before.
+void PressureSolver::computePressureAccelerations(const std::vector<float> &pressure)
+{
+	ParticleStore &ps = *particles;
+
+	if (!neighbors->isSymmetric) {
+		up::parallelFor(
+			ps.size(),
+			[this, &ps, &pressure](size_t i)
+			{
+				if (ps.isBoundary[i]) return;
+
+				ps.pressureAcceleration[i] = computePressureAcceleration(i, pressure);
+			});
+
+		return;
+	}
+
+	pairAccelerations.resize(neighbors->numPairs());
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps, &pressure](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			neighbors->forEachOwnedFluid(i, [&](size_t p, uint32_t j)
+				{
+					//The self pair is its own mirror and has a zero gradient
+					if (j == i) {
+						pairAccelerations[p] = up::Vec2(0.f, 0.f);
+						return;
+					}
+
+					up::Vec2 gradientij = pairGradient(p, i, j);
+					//Note: Adjust in case rest densities are different
+					float pressureTerm = (pressure[i] + pressure[j]) / restDensitySquared;
+
+					pairAccelerations[neighbors->mirror[p]] = ps.mass[i] * pressureTerm * (-1 * gradientij);
+					pairAccelerations[p] = ps.mass[j] * pressureTerm * gradientij;
+				});
+		});
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps, &pressure](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			up::Vec2 summedTerm1 = { 0.f, 0.f };
+
+			for (size_t p : neighbors->fluidPairs(i)) summedTerm1 += pairAccelerations[p];
+
+			ps.pressureAcceleration[i] = -1 * summedTerm1 - (gamma * computeBoundaryPressureTerm(i, pressure));
+		});
+}
+
 //Check boundary contribution
 //Compute the divergence of the velocity change delta(ta) due to the pressure acceleration
-float PressureSolver::computeDivergence(std::shared_ptr<Particle> pi) 
+float PressureSolver::computeDivergence(size_t i) 
 {
+	const ParticleStore &ps = *particles;
 	float divergence;
 	float summedDivergence1 = 0.f;
 	float summedDivergence2 = 0.f;
 
-	for (auto &pj : pi->neighbors)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedDivergence1 += pj->mass * (pi->pressureAcceleration - pj->pressureAcceleration).dot(gradientij);
-	}
+			summedDivergence1 += ps.mass[j] * (ps.pressureAcceleration[i] - ps.pressureAcceleration[j]).dot(gradientij);
+		});
 	
-	for (auto &pj : pi->neighborsBoundary)
-	{
-		up::Vec2 distanceVectorij = pi->position_current - pj->position_current;
-		up::Vec2 gradientij = kernelGradient(distanceVectorij);
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			up::Vec2 gradientij = pairGradient(p, i, j);
 
-		summedDivergence2 += pj->mass * (pi->pressureAcceleration).dot(gradientij);
-	}
+			summedDivergence2 += ps.mass[j] * (ps.pressureAcceleration[i]).dot(gradientij);
+		});
 
 	divergence = (*dt) * (*dt) * (summedDivergence1 + summedDivergence2);
 
@@ -275,8 +489,8 @@ float PressureSolver::computeDivergence(std::shared_ptr<Particle> pi)
 }
 
 //Play around with omega value
-void PressureSolver::updatePressure(std::shared_ptr<Particle> pi) {
+void PressureSolver::updatePressure(size_t i) {
 	float omega = 0.5f;
 
-	pi->pressure = std::max(pi->pressure + (omega * (pi->predictedDensityError - pi->negVelocityDivergence)/pi->diagonalElement), 0.f);
-}
\ No newline at end of file
+	particles->pressure[i] = std::max(particles->pressure[i] + (omega * (particles->predictedDensityError[i] - particles->negVelocityDivergence[i])/particles->diagonalElement[i]), 0.f);
+}
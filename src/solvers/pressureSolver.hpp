@@ -1,29 +1,102 @@
 #pragma once
 
 #include "helpers/compactCell.hpp"
-#include "particles/particle2.hpp"
+#include "helpers/neighborList.hpp"
+#include "particles/particleStore.hpp"
 #include "solvers/solverBase.hpp"
+#include <atomic>
 #include <bitset>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <vector>
 
 class PressureSolver: public SolverBase {
 
 public:
-	PressureSolver(std::vector<std::shared_ptr<Particle>> *_particles, int *_numFluidParticles, float *_dt, std::ofstream *_simDataFile);
+	PressureSolver(ParticleStore *_particles, NeighborList *_neighbors, int *_numFluidParticles, float *_dt, std::ofstream *_simDataFile);
 	void compute() override;
+	void initialize();
+	float iterate();
+	void computePressureAccelerations(const std::vector<float> &pressure);
+
+	//Warm start: every solve begins from the pressure of the previous step instead of zero, with the same
+	//convergence criterion. Scaled, the pressure is multiplied by (previous dt / dt)^2, as A scales with dt^2.
+	enum class WarmStart
+	{
+		Off,
+		Previous,
+		DtScaled
+	};
+
+	WarmStart warmStart = WarmStart::Off;
+
+	//Active set: in late iterations, the Jacobi iterations between full ones only update the particles whose residual
+	//is still above tolerance and only recompute the accelerations of those and their neighbors. Full iterations
+	//check the error over all particles, so the result meets the same criterion.
+	bool activeSet = false;
+
+	//Set while the solver's fused init kernel writes source term and diagonal, initialize() then only resets the pressure
+	bool fusedInitialization = false;
+
+	float computeSourceTerm(size_t i);
+	float diagonalFromSums(size_t i, up::Vec2 fluidGradientSum, up::Vec2 boundaryGradientSum, float fluidGradientSquaredSum) const;
+
+protected:
+	static constexpr float MAX_DENSITY_ERROR = 0.001f;
+	//Per particle residual below which a particle leaves the active set
+	static constexpr float ACTIVE_RESIDUAL = MAX_DENSITY_ERROR;
+	//Full iterations before the first active set iterations, most solves converge within them
+	static constexpr int ACTIVE_AFTER_ITERATIONS = 8;
+	//Active set iterations between two full iterations
+	static constexpr int MAX_ACTIVE_ITERATIONS = 8;
 
-private:
 	int MIN_ITERATIONS = 2;
 	int *numFluidParticles;
 
 	float gamma = 1.f;
 	float *dt;
+	float previousDt = 0.f;
 	float restDensitySquared = PARTICLE_REST_DENSITY * PARTICLE_REST_DENSITY;
+	float predictedDensityErrorAvg = 0.f;
+	up::Vec2 currentParticlePredictedVelocity;
+	up::Vec2 currentParticleVelocity;
 	std::ofstream *simDataFile;
-	std::vector<std::shared_ptr<Particle>> *particles;
+	ParticleStore *particles;
+	NeighborList *neighbors;
+
+	//Particles whose pressure is updated, the particles whose acceleration is recomputed, and the stamps
+	//that keep a particle from being gathered twice into the latter
+	std::vector<uint32_t> updateSet;
+	std::vector<uint32_t> compactScratch;
+	std::vector<uint32_t> accelerationSet;
+	std::unique_ptr<std::atomic<uint32_t>[]> gatherStamps;
+	size_t stampCapacity = 0;
+	uint32_t gatherStamp = 0;
+	//Density error of the particles that left the update set, summed when they left
+	float frozenErrorSum = 0.f;
+
+	//Kernel gradient of pair p between particle i and its neighbor j, read from the pair cache when enabled
+	up::Vec2 pairGradient(size_t p, size_t i, size_t j) const
+	{
+		if (neighbors->hasPairCache) return neighbors->kernelGradients[p];
+
+		up::Vec2 distanceVector = particles->position[i] - particles->position[j];
+		return neighbors->inSupport(distanceVector) ? kernelGradient(distanceVector) : up::Vec2(0.f, 0.f);
+	}
+
+	//Fluid pressure terms per pair of a symmetric list, see computePressureAccelerations
+	std::vector<up::Vec2> pairAccelerations;
 
-	float computeSourceTerm(std::shared_ptr<Particle> pi);
-	float computeDiagonal(std::shared_ptr<Particle> pi);
-	up::Vec2 computePressureAcceleration(std::shared_ptr<Particle> pi);
-	float computeDivergence(std::shared_ptr<Particle> pi);
-	void updatePressure(std::shared_ptr<Particle> pi);
+	float computeDiagonal(size_t i);
+	up::Vec2 computePressureAcceleration(size_t i, const std::vector<float> &pressure);
+	up::Vec2 computeBoundaryPressureTerm(size_t i, const std::vector<float> &pressure);
+	float computeDivergence(size_t i);
+	void updatePressure(size_t i);
+	void writeStatistics(float densityErrorAvg);
+	float solveActiveSet();
+	float iterateActiveSet();
+	bool isUnconverged(size_t i) const;
+	void collectUpdateSet();
+	void gatherAccelerationSet();
 };
\ No newline at end of file
@@ -6,38 +6,83 @@
 #include <iostream>
 #include <algorithm>
 #include <execution>
+#include "helpers/parallel.hpp"
 
-Solver::Solver()
+Solver::Solver(const std::string &dataFilePath)
 	: centerPosition({ 3000.0f, 0.0f }),
-	particles({}),
-	simDataFile(setupDataFile())
+	simDataFile(setupDataFile(dataFilePath))
 {
-	solvers.push_back(std::move(std::make_shared<NeighborSearch>("ZIndex", &particles)));
-	solvers.push_back(std::move(std::make_shared<PressureSolver>(&particles, &numFluidParticles, &dt, &simDataFile)));
+	solvers.push_back(NeighborSearch::create("ZIndex", &particles, &neighbors));
+	solvers.push_back(std::move(std::make_shared<PressureSolver>(&particles, &neighbors, &numFluidParticles, &dt, &simDataFile)));
 	clock.restart();
 	simTimeClock.restart();
 	pressureClock.restart();
 	neighborClock.restart();
 }
 
-std::ofstream Solver::setupDataFile()
+//An empty path disables logging
+std::ofstream Solver::setupDataFile(const std::string &dataFilePath)
 {
+	if (dataFilePath.empty()) return std::ofstream();
+
 	//Create logging file
-	std::ofstream simDataFile("simulation_data.csv");
+	std::ofstream simDataFile(dataFilePath);
 
 	// Write the header row in the CSV file
 	simDataFile << 
-		"Sim Iteration,Neighbor Search time,Pressure iteration,Density error average,Predicted density error average,Predicted velocity,Actual velocity,Pressure Solver time,Physics sim time, Render time" 
+		"Sim Iteration,Neighbor Search time,Pressure iteration,Density error average,Predicted density error average,Predicted velocity,Actual velocity,Divergence iteration,Pressure Solver time,Physics sim time, Render time" 
 		<< std::endl;
 
 	return simDataFile;
 }
 
+//Replaces the neighbor search with one ordering cells along the given curve (XYZ, ZIndex or HILBERT).
+//Returns false and keeps the current search for unknown names.
+bool Solver::setSpaceFillingCurve(const std::string &curveName)
+{
+	auto neighborSearch = NeighborSearch::create(curveName, &particles, &neighbors);
+
+	if (!neighborSearch) return false;
+
+	solvers.at(0) = neighborSearch;
+	return true;
+}
+
+//Selects how neighbors are found: "grid" sorts compact cells along the space filling curve,
+//"hash" hashes cell coordinates and works on scenes of any extent. Returns false for unknown names.
+bool Solver::setNeighborSearchBackend(const std::string &backendName)
+{
+	if (backendName == "grid") setSpaceFillingCurve("ZIndex");
+	else if (backendName == "hash") solvers.at(0) = std::make_shared<SpatialHashSearch>(&particles, &neighbors);
+	else return false;
+
+	return true;
+}
+
+//Selects how the pressure system is solved: "jacobi" runs relaxed Jacobi, "cg" the preconditioned
+//BiCGSTAB, "wcsph" a single state equation pass and "dfsph" the divergence-free solver. Returns false for unknown names.
+bool Solver::setPressureSolver(const std::string &solverName)
+{
+	if (solverName == "jacobi") solvers.at(1) = std::make_shared<PressureSolver>(&particles, &neighbors, &numFluidParticles, &dt, &simDataFile);
+	else if (solverName == "cg") solvers.at(1) = std::make_shared<ConjugateGradientSolver>(&particles, &neighbors, &numFluidParticles, &dt, &simDataFile);
+	else if (solverName == "wcsph") solvers.at(1) = std::make_shared<StateEquationSolver>(&particles, &neighbors, &numFluidParticles, &STIFFNESS, &simDataFile);
+	else if (solverName == "dfsph") solvers.at(1) = std::make_shared<DivergenceFreeSolver>(&particles, &neighbors, &numFluidParticles, &dt, &simDataFile);
+	else return false;
+
+	return true;
+}
+
 void Solver::closeFile()
 {
 	simDataFile.close();
 }
 
+//Closes the current row of the data file. The frontend reports how long it took to present the step.
+void Solver::finishDataRow(long long renderTime)
+{
+	simDataFile << "," << renderTime << std::endl;
+}
+
 void Solver::update()
 {
 	//if (!stepUpdate && !updating) updating = true;
@@ -51,26 +96,37 @@ void Solver::update()
 	//Neighbor search
 	neighborClock.restart();
 	solvers.at(0)->compute();
-	simDataFile << "," << neighborClock.getElapsedTime().asMilliseconds();
-	//Density calculation
-	computeDensity();
-	//Non pressure acceleration and predicted velocity calculation
-	computeNonPressureForces();
+	highlightNeighbors();
+	simDataFile << "," << neighborClock.elapsedMilliseconds();
+	//Kept out of the neighbor search column, it counts towards the physics time only
+	computePairCache();
+	auto pressureSolver = std::dynamic_pointer_cast<PressureSolver>(solvers.at(1));
+	bool fusedInit = useFusedInit && pressureSolver;
+	if (pressureSolver) pressureSolver->fusedInitialization = fusedInit;
+
+	//The fused kernel writes the pressure solver's source term and diagonal, other solvers use the separate loops
+	if (fusedInit) computeFusedInit();
+	else {
+		//Density calculation
+		computeDensity();
+		//Non pressure acceleration and predicted velocity calculation
+		computeNonPressureForces();
+	}
 	//Pressure solver
 	pressureClock.restart();
 	solvers.at(1)->compute();
-	simDataFile << "," << pressureClock.getElapsedTime().asMilliseconds();
+	simDataFile << "," << pressureClock.elapsedMilliseconds();
 	//Pressure acceleration
 	applyPressureForce();
 	//Time integration
 	updatePositions();
 
-	if (clock.getElapsedTime().asSeconds() > 3.f) {
+	if (clock.elapsedSeconds() > 3.f) {
 		clock.restart();
 		moveDirection *= -1;
 	}
 
-	simDataFile << "," << simTimeClock.getElapsedTime().asMilliseconds();
+	simDataFile << "," << simTimeClock.elapsedMilliseconds();
 
 	if (stepUpdate) updating = false;
 }
@@ -107,40 +163,97 @@ up::Vec2 Solver::kernelGradient(up::Vec2 distanceVector)
 	return ALPHA * (distanceVector / (distance * PARTICLE_SPACING)) * (-3 * pow(t2, 2) - 12 * pow(t1, 2));
 }
 
-//Computes density
-void Solver::computeDensity()
+//Highlight the neighbors of the selected particles. Neighborhoods are symmetric,
+//so every particle can look for a selected particle in its own row without racing.
+//Neighbor lists are symmetric, so only the rows of the selected particles are walked.
+//No neighbor row is walked when no particle is selected.
+void Solver::highlightNeighbors()
 {
-	std::for_each(
-		std::execution::par,
-		particles.begin(),
-		particles.end(),
-		[this](auto&& pi)
-		{
-			if (pi->isBoundary) return;
+	std::fill(particles.isTheOneNeighbor.begin(), particles.isTheOneNeighbor.end(), 0);
 
-			float sphDensity = 0.f;
+	for (size_t k = 0; k < particles.size(); k++)
+	{
+		if (!particles.theOne[k]) continue;
 
-			for (auto &pj : pi->neighbors)
+		neighbors.forEachNeighbor(k, particles, [&](uint32_t l)
 			{
-				up::Vec2 distanceVector = pi->position_current - pj->position_current;
-				float distance = distanceVector.length();
-				
-				sphDensity += pj->mass * kernelFunction(distance);
-			}
-			
-			for (auto &pj : pi->neighborsBoundary)
+				if (!particles.theOne[l] && neighbors.inSupport(particles.position[k] - particles.position[l])) particles.isTheOneNeighbor[l] = true;
+			});
+	}
+}
+
+//Evaluates W_ij and grad W_ij once per neighbor pair. Positions do not change until the
+//time integration, so every later loop of the step can read them instead of recomputing.
+//Pairs of a Verlet list that lie outside the support get zero entries. Symmetric lists evaluate every
+//pair once and write its mirror too, the kernel is symmetric and its gradient antisymmetric.
+//The list-free mode stores no pairs, so there is nothing to cache.
+void Solver::computePairCache()
+{
+	neighbors.hasPairCache = usePairCache && !neighbors.isCellPairs;
+
+	if (!neighbors.hasPairCache) {
+		neighbors.kernelValues = {};
+		neighbors.kernelGradients = {};
+		return;
+	}
+
+	neighbors.kernelValues.resize(neighbors.numPairs());
+	neighbors.kernelGradients.resize(neighbors.numPairs());
+
+	up::parallelFor(
+		neighbors.numParticles(),
+		[this](size_t i)
+		{
+			for (size_t p : neighbors.allPairs(i))
 			{
-				up::Vec2 distanceVector = pi->position_current - pj->position_current;
-				float distance = distanceVector.length();
+				uint32_t j = neighbors.indices[p];
+
+				//The particle with the lower index owns the pair, so no mirror is written twice
+				if (neighbors.isSymmetric && j < i) continue;
+
+				up::Vec2 distanceVector = particles.position[i] - particles.position[j];
+				float kernelValue = 0.f;
+				up::Vec2 gradient(0.f, 0.f);
 
-				sphDensity += pj->mass * kernelFunction(distance);
+				if (neighbors.inSupport(distanceVector)) {
+					kernelValue = kernelFunction(distanceVector.length());
+					gradient = SolverBase::kernelGradient(distanceVector);
+				}
+
+				neighbors.kernelValues[p] = kernelValue;
+				neighbors.kernelGradients[p] = gradient;
 
-				//pj->pressure = pi->pressure;
+				if (neighbors.isSymmetric) {
+					neighbors.kernelValues[neighbors.mirror[p]] = kernelValue;
+					neighbors.kernelGradients[neighbors.mirror[p]] = -1 * gradient;
+				}
 			}
+		});
+}
+
+//Computes density
+void Solver::computeDensity()
+{
+	up::parallelFor(
+		particles.size(),
+		[this](size_t i)
+		{
+			if (particles.isBoundary[i]) return;
+
+			float sphDensity = 0.f;
+
+			neighbors.forEachFluid(i, particles, [&](size_t p, uint32_t j)
+				{
+					sphDensity += particles.mass[j] * pairKernel(p, i, j);
+				});
+			
+			neighbors.forEachBoundary(i, particles, [&](size_t p, uint32_t j)
+				{
+					sphDensity += particles.mass[j] * pairKernel(p, i, j);
+				});
 			
-			pi->density = sphDensity;
-			//pi->pressure = std::max(STIFFNESS * (sphDensity - 1.0f), 0.f);
-			pi->updateVolume();
+			particles.density[i] = sphDensity;
+			particles.updateVolume(i);
 		});
 }
 
@@ -149,82 +262,178 @@ void Solver::computeDensity()
 //Only applies to liquid particles
 void Solver::computeNonPressureForces()
 {
-	std::for_each(
-		std::execution::par,
-		particles.begin(),
-		particles.end(),
-		[this](auto&& pi)
+	bool hasPairViscosity = VISCOSITY > 0.f && neighbors.isSymmetric;
+
+	if (hasPairViscosity) computePairViscosity();
+
+	up::parallelFor(
+		particles.size(),
+		[this, hasPairViscosity](size_t i)
 		{
-			if (pi->isMovableBoundary) pi->velocity = up::Vec2(100.f * moveDirection, 0.f); //Add scripted movement
+			if (particles.isMovableBoundary[i]) particles.velocity[i] = up::Vec2(100.f * moveDirection, 0.f); //Add scripted movement
 
-			if (pi->isBoundary) return;
+			if (particles.isBoundary[i]) return;
 
 			up::Vec2 fviscosity(0.f, 0.f);
 
-			if (VISCOSITY > 0.f) {
-				for (auto &pj : pi->neighbors)
-				{
-					up::Vec2 distanceVector = pi->position_current - pj->position_current;
-					up::Vec2 velocityDiff = pi->velocity - pj->velocity;
+			if (hasPairViscosity) {
+				for (size_t p : neighbors.fluidPairs(i)) fviscosity += pairViscosity[p];
+			}
+			else if (VISCOSITY > 0.f) {
+				neighbors.forEachFluid(i, particles, [&](size_t, uint32_t j)
+					{
+						up::Vec2 distanceVector = particles.position[i] - particles.position[j];
 
-					float distance = distanceVector.length();
+						if (!neighbors.inSupport(distanceVector)) return;
 
-					//compute viscosity force contribution (non-pressure acceleration)
-					//Viscosity without second derivative, check slide 72
-					fviscosity += ((pj->mass / pj->density) *
-						(velocityDiff.dot(distanceVector) / (distanceVector.dot(distanceVector) + 0.01f*PARTICLE_SPACING*PARTICLE_SPACING))) *
-						kernelGradient(distanceVector);
-				}
+						up::Vec2 velocityDiff = particles.velocity[i] - particles.velocity[j];
+
+						//compute viscosity force contribution (non-pressure acceleration)
+						//Viscosity without second derivative, check slide 72
+						fviscosity += ((particles.mass[j] / particles.density[j]) *
+							(velocityDiff.dot(distanceVector) / (distanceVector.dot(distanceVector) + 0.01f*PARTICLE_SPACING*PARTICLE_SPACING))) *
+							kernelGradient(distanceVector);
+					});
 			}
 			
-			//up::Vec2 pointGravity = applyPointGravity(pi);
-			//pi->forces = VISCOSITY * fviscosity + pointGravity;
+			//up::Vec2 pointGravity = applyPointGravity(i);
+			//particles.forces[i] = VISCOSITY * fviscosity + pointGravity;
 
 			//Sum non-pressure accelerations
-			pi->viscosityAcceleration = VISCOSITY * fviscosity;
-			pi->forces = VISCOSITY * fviscosity + GRAVITY * pi->mass;
-			pi->predictedVelocity = pi->velocity + dt * pi->forces;
+			particles.viscosityAcceleration[i] = VISCOSITY * fviscosity;
+			particles.forces[i] = VISCOSITY * fviscosity + GRAVITY * particles.mass[i];
+			particles.predictedVelocity[i] = particles.velocity[i] + dt * particles.forces[i];
+		});
+}
+
+//Viscosity terms of a symmetric list, computed once per fluid pair by its owner. Velocity difference and distance
+//vector both flip with the pair, so the scalar factor is shared and only mass, density and gradient sign differ.
+void Solver::computePairViscosity()
+{
+	pairViscosity.resize(neighbors.numPairs());
+
+	up::parallelFor(
+		particles.size(),
+		[this](size_t i)
+		{
+			if (particles.isBoundary[i]) return;
+
+			neighbors.forEachOwnedFluid(i, [&](size_t p, uint32_t j)
+				{
+					//The self pair is its own mirror and has no velocity difference
+					if (j == i) {
+						pairViscosity[p] = up::Vec2(0.f, 0.f);
+						return;
+					}
+
+					up::Vec2 distanceVector = particles.position[i] - particles.position[j];
+					up::Vec2 velocityDiff = particles.velocity[i] - particles.velocity[j];
+					up::Vec2 term(0.f, 0.f);
+
+					if (neighbors.inSupport(distanceVector)) {
+						term = (velocityDiff.dot(distanceVector) / (distanceVector.dot(distanceVector) + 0.01f*PARTICLE_SPACING*PARTICLE_SPACING)) *
+							kernelGradient(distanceVector);
+					}
+
+					pairViscosity[neighbors.mirror[p]] = (particles.mass[i] / particles.density[i]) * (-1 * term);
+					pairViscosity[p] = (particles.mass[j] / particles.density[j]) * term;
+				});
 		});
 }
 
-up::Vec2 Solver::applyPointGravity(std::shared_ptr<Particle> p) {
-	float dx = centerPosition.x - p->position_current.x;
-	float dy = centerPosition.y - p->position_current.y;
-	float force = GRAVITY.y * p->mass;
+//Density, non-pressure acceleration, predicted velocity, source term and diagonal element in two neighbor sweeps.
+//The first sweep reads kernel values and gradients once per pair for the density and the diagonal sums, the
+//predicted velocity only depends on the particle itself while viscosity is disabled. The source term needs the
+//predicted velocities of the neighbors, so it takes the second sweep. With viscosity, which needs the densities
+//of the neighbors, the non-pressure forces take a sweep of their own in between.
+void Solver::computeFusedInit()
+{
+	auto pressureSolver = std::dynamic_pointer_cast<PressureSolver>(solvers.at(1));
+
+	up::parallelFor(
+		particles.size(),
+		[this, &pressureSolver](size_t i)
+		{
+			if (particles.isMovableBoundary[i]) particles.velocity[i] = up::Vec2(100.f * moveDirection, 0.f); //Add scripted movement
+
+			if (particles.isBoundary[i]) return;
+
+			float sphDensity = 0.f;
+			up::Vec2 fluidGradientSum(0.f, 0.f);
+			up::Vec2 boundaryGradientSum(0.f, 0.f);
+			float fluidGradientSquaredSum = 0.f;
+
+			neighbors.forEachFluid(i, particles, [&](size_t p, uint32_t j)
+				{
+					up::Vec2 gradient = pairGradient(p, i, j);
+
+					sphDensity += particles.mass[j] * pairKernel(p, i, j);
+					fluidGradientSum += particles.mass[j] * gradient;
+					fluidGradientSquaredSum += particles.mass[j] * gradient.dot(gradient);
+				});
+
+			neighbors.forEachBoundary(i, particles, [&](size_t p, uint32_t j)
+				{
+					sphDensity += particles.mass[j] * pairKernel(p, i, j);
+					boundaryGradientSum += particles.mass[j] * pairGradient(p, i, j);
+				});
+
+			particles.density[i] = sphDensity;
+			particles.updateVolume(i);
+			particles.diagonalElement[i] = pressureSolver->diagonalFromSums(i, fluidGradientSum, boundaryGradientSum, fluidGradientSquaredSum);
+
+			if (VISCOSITY > 0.f) return;
+
+			particles.viscosityAcceleration[i] = up::Vec2(0.f, 0.f);
+			particles.forces[i] = GRAVITY * particles.mass[i];
+			particles.predictedVelocity[i] = particles.velocity[i] + dt * particles.forces[i];
+		});
+
+	if (VISCOSITY > 0.f) computeNonPressureForces();
+
+	up::parallelFor(
+		particles.size(),
+		[this, &pressureSolver](size_t i)
+		{
+			if (particles.isBoundary[i]) return;
+
+			particles.predictedDensityError[i] = pressureSolver->computeSourceTerm(i);
+		});
+}
+
+up::Vec2 Solver::applyPointGravity(size_t i) {
+	float dx = centerPosition.x - particles.position[i].x;
+	float dy = centerPosition.y - particles.position[i].y;
+	float force = GRAVITY.y * particles.mass[i];
 
 	return { force * dx, force * dy };
 }
 
 void Solver::applyPressureForce() {
-	std::for_each(
-		std::execution::par,
-		particles.begin(),
-		particles.end(),
-		[this](auto&& pi)
+	up::parallelFor(
+		particles.size(),
+		[this](size_t i)
 		{
-			if (pi->isBoundary) return;
+			if (particles.isBoundary[i]) return;
 			
-			pi->forces += pi->pressureAcceleration * pi->mass; //Sum pressure accelerations Check mass multiplication
+			particles.forces[i] += particles.pressureAcceleration[i] * particles.mass[i]; //Sum pressure accelerations Check mass multiplication
 		});
 }
 
 void Solver::updatePositions()
 {
-	maxVelocity = 0.f;
-
-	std::for_each(
-		std::execution::par,
-		particles.begin(),
-		particles.end(),
-		[this](auto&& p)
+	maxVelocity = up::parallelMax(
+		particles.size(),
+		0.f,
+		[this](size_t i)
 		{
-			if (!p->isBoundary || p->isMovableBoundary) {
-				float velocity = p->updatePositionEuler(this->dt);
-				if (velocity > maxVelocity) {
-					maxVelocity = velocity;
-				}
-			}
-			
+			if (particles.isBoundary[i] && !particles.isMovableBoundary[i]) return 0.f;
+
+			//Explicit Euler integration
+			particles.velocity[i] += dt * particles.forces[i] / particles.mass[i];
+			particles.position[i] += dt * particles.velocity[i];
+
+			return sqrt(particles.velocity[i].x * particles.velocity[i].x + particles.velocity[i].y * particles.velocity[i].y);
 		});
 
 	if (maxVelocity < 1) maxVelocity = PARTICLE_SPACING;
@@ -233,21 +442,10 @@ void Solver::updatePositions()
 }
 
 //Slide 11
-void Solver::addParticle(float starting_x, float starting_y, bool isBoundary, sf::Color color, bool isTheOne, bool isMovableBoundary) {
+void Solver::addParticle(float starting_x, float starting_y, bool isBoundary, up::Color color, bool isTheOne, bool isMovableBoundary) {
 	float volume = PARTICLE_SPACING * PARTICLE_SPACING;
 
-	Particle newParticle2{
-		{ starting_x, starting_y },
-		{ starting_x, starting_y },
-		{0.f, 0.f},
-		volume,
-		isBoundary,
-		color,
-		isTheOne,
-		isMovableBoundary,
-	};
-
-	particles.push_back(std::make_shared<Particle>(newParticle2));
+	particles.add({ starting_x, starting_y }, volume, isBoundary, color, isTheOne, isMovableBoundary);
 
 	if (!isBoundary) numFluidParticles++;
 }
@@ -263,7 +461,7 @@ void Solver::initializeBoundaryParticles()
 		float posX = cos(2 * (float) M_PI*i / particlesToSpawn) * radius + centerPosition.x;
 		float posY = sin(2 * (float) M_PI*i /particlesToSpawn) * radius + centerPosition.y;
 
-		addParticle(posX, posY, true, sf::Color::Red);
+		addParticle(posX, posY, true, up::Color::Red);
 	}
 }
 
@@ -282,14 +480,14 @@ void Solver::initializeBoundaryParticlesSquare()
 		float posX = i * sideLength / particlesToAdd + minX;
 		float posY = i * sideLength / particlesToAdd + minY;
 
-		addParticle(posX, minY, true, sf::Color::Red);
-		addParticle(minX, posY, true, sf::Color::Red);
-		addParticle(maxX, posY, true, sf::Color::Red);
-		addParticle(posX, maxY, true, sf::Color::Red);
+		addParticle(posX, minY, true, up::Color::Red);
+		addParticle(minX, posY, true, up::Color::Red);
+		addParticle(maxX, posY, true, up::Color::Red);
+		addParticle(posX, maxY, true, up::Color::Red);
 	}
 }
 
-void Solver::initializeLiquidParticles(sf::Vector2f initialPos, sf::Vector2f endPos)
+void Solver::initializeLiquidParticles(up::Vec2 initialPos, up::Vec2 endPos)
 {
 	float minX = initialPos.x;
 	float minY = initialPos.y;
@@ -301,7 +499,7 @@ void Solver::initializeLiquidParticles(sf::Vector2f initialPos, sf::Vector2f end
 
 	while (currentY < maxY)
 	{
-		addParticle(currentX, currentY, false, sf::Color::Blue);
+		addParticle(currentX, currentY, false, up::Color::Blue);
 
 		currentX += PARTICLE_SPACING;
 
@@ -321,7 +519,7 @@ void Solver::initializeLiquidParticles(int initialParticles)
 
 	for (int i = 0; i < initialParticles; i++)
 	{
-		addParticle(xPosition, yPosition, false, sf::Color::Blue);
+		addParticle(xPosition, yPosition, false, up::Color::Blue);
 		if (xPosition < centerPosition.x + radius/8) xPosition += PARTICLE_SPACING;
 		else
 		{
@@ -341,11 +539,11 @@ void Solver::initializeLiquidParticles()
 	for (int i = 1; i <= 9; i++)
 	{
 		bool isChosenOne = false;
-		sf::Color particleColor = sf::Color::Blue;
+		up::Color particleColor = up::Color::Blue;
 
 		if (i == 5) {
 			isChosenOne = true;
-			particleColor = sf::Color::Green;
+			particleColor = up::Color::Green;
 		}
 
 		addParticle(xPosition, yPosition, false, particleColor, isChosenOne);
@@ -369,13 +567,13 @@ void Solver::initializeMovingParticlesCircle(float posX, float posY, float radiu
 		float spawnPosX = cos(2 * (float) M_PI*i / particlesToSpawn) * radiusCircle + posX;
 		float spawnPosY = sin(2 * (float) M_PI*i / particlesToSpawn) * radiusCircle + posY;
 
-		addParticle(spawnPosX, spawnPosY, true, sf::Color::Red, false, isMovable);
+		addParticle(spawnPosX, spawnPosY, true, up::Color::Red, false, isMovable);
 	}
 }
 
 void Solver::handleAddWall(float positionX, float positionY, bool isMovable)
 {
-	if(!isMovable) addParticle(positionX, positionY, true, sf::Color::Red, false, isMovable);
+	if(!isMovable) addParticle(positionX, positionY, true, up::Color::Red, false, isMovable);
 
 	if (initialWallPoint.x == -1.f)
 	{
@@ -393,7 +591,7 @@ void Solver::handleAddWall(float positionX, float positionY, bool isMovable)
 			float posX = i * wallVector.x / particlesToAdd + initialWallPoint.x;
 			float posY = i * wallVector.y / particlesToAdd + initialWallPoint.y;
 
-			addParticle(posX, posY, true, sf::Color::Red, false, isMovable);
+			addParticle(posX, posY, true, up::Color::Red, false, isMovable);
 		}
 
 		initialWallPoint = { -1.f, -1.f };
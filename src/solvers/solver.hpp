@@ -2,12 +2,17 @@
 
 #define _USE_MATH_DEFINES
 
-//#include "particle.hpp"
-#include "particles/particle2.hpp"
+#include "particles/particleStore.hpp"
+#include "helpers/neighborList.hpp"
+#include "helpers/clock.hpp"
+#include "helpers/color.hpp"
 #include "helpers/compactCell.hpp"
-#include "helpers/hilbert_curve.hpp"
+#include "solvers/conjugateGradientSolver.hpp"
+#include "solvers/divergenceFreeSolver.hpp"
 #include "solvers/neightborSearch.hpp"
 #include "solvers/pressureSolver.hpp"
+#include "solvers/spatialHashSearch.hpp"
+#include "solvers/stateEquationSolver.hpp"
 #include "solvers/solverBase.hpp"
 
 #include <memory>
@@ -17,11 +22,12 @@
 #include <bitset>
 #include <execution>
 #include <fstream>
+#include <string>
 
 class Solver {
 
 public:
-	Solver();
+	Solver(const std::string &dataFilePath = "simulation_data.csv");
 	
 	std::ofstream simDataFile;
 
@@ -36,7 +42,8 @@ public:
 	static constexpr float SIM_WIDTH = 1200.f;
 	static constexpr float SIM_HEIGHT = 700.f;
 	static constexpr int DIMENSION = 2;
-	float STIFFNESS = 1000000.f;
+	//State equation stiffness of the wcsph solver, larger values need smaller time steps
+	float STIFFNESS = 100000.f;
 
 	static constexpr float radius = 1000.0f;
 
@@ -46,41 +53,77 @@ public:
 
 	up::Vec2 GRAVITY{ 0.f, 9.8f };
 
-	std::vector<std::shared_ptr<Particle>> particles;
+	ParticleStore particles;
+	NeighborList neighbors;
 	std::vector<std::shared_ptr <SolverBase>> solvers;
 
+	//Cache kernel values and gradients per neighbor pair instead of recomputing them in every loop
+	bool usePairCache = true;
+
+	//Replace computeDensity, computeNonPressureForces and the pressure solver's initialization by computeFusedInit
+	bool useFusedInit = false;
+
 	float dt = 0.01f;
 	float dtSum = 0.f;
 	int moveDirection = 1;
 
-	std::ofstream setupDataFile();
+	std::ofstream setupDataFile(const std::string &dataFilePath);
+	bool setSpaceFillingCurve(const std::string &curveName);
+	bool setNeighborSearchBackend(const std::string &backendName);
+	bool setPressureSolver(const std::string &solverName);
 	void closeFile();
+	void finishDataRow(long long renderTime);
 	void update();
+	void highlightNeighbors();
+	void computePairCache();
 	void computeDensity();
 	float kernelFunction(float distance);
 	up::Vec2 kernelGradient(up::Vec2 distanceVector);
 	void computeNonPressureForces(void);
+	void computePairViscosity();
+	void computeFusedInit();
 	void updatePositions();
-	void addParticle(float starting_x, float starting_y, bool isBoundary, sf::Color color, 
+	void addParticle(float starting_x, float starting_y, bool isBoundary, up::Color color, 
 		bool isTheOne = false, bool isMovableBoundary = false);
 	void initializeBoundaryParticles();
 	void initializeBoundaryParticlesSquare();
-	void initializeLiquidParticles(sf::Vector2f initialPos, sf::Vector2f endPos);
+	void initializeLiquidParticles(up::Vec2 initialPos, up::Vec2 endPos);
 	void initializeLiquidParticles(int initialParticles);
 	void initializeLiquidParticles();
 	void initializeMovingParticlesCircle(float posX, float posY, float radiusCircle, bool isMovable = false);
 	void applyPressureForce();
 	void handleAddWall(float positionX, float positionY, bool isMovable = false);
-	up::Vec2 applyPointGravity(std::shared_ptr<Particle> p);
+	up::Vec2 applyPointGravity(size_t i);
 
 private:
+	//Density kernel value of pair p between particle i and its neighbor j, read from the pair cache when enabled
+	float pairKernel(size_t p, size_t i, size_t j)
+	{
+		if (neighbors.hasPairCache) return neighbors.kernelValues[p];
+
+		up::Vec2 distanceVector = particles.position[i] - particles.position[j];
+		return neighbors.inSupport(distanceVector) ? kernelFunction(distanceVector.length()) : 0.f;
+	}
+
+	//Kernel gradient of pair p, read from the pair cache when enabled
+	up::Vec2 pairGradient(size_t p, size_t i, size_t j)
+	{
+		if (neighbors.hasPairCache) return neighbors.kernelGradients[p];
+
+		up::Vec2 distanceVector = particles.position[i] - particles.position[j];
+		return neighbors.inSupport(distanceVector) ? SolverBase::kernelGradient(distanceVector) : up::Vec2(0.f, 0.f);
+	}
+
+	//Viscosity terms per pair of a symmetric list, see computePairViscosity
+	std::vector<up::Vec2> pairViscosity;
+
 	//Implement CFL variable time step. calculate at beginning of computation.
 	float CFL = 0.1f;
 	float maxVelocity = 0.f;
 	float ALPHA = 5.f / (14.f * (float) M_PI * PARTICLE_SPACING * PARTICLE_SPACING);
-	sf::Clock clock;
-	sf::Clock pressureClock;
-	sf::Clock simTimeClock;
-	sf::Clock neighborClock;
+	up::Clock clock;
+	up::Clock pressureClock;
+	up::Clock simTimeClock;
+	up::Clock neighborClock;
 	int iteration = 0;
 };
\ No newline at end of file
@@ -9,7 +9,7 @@ class SolverBase
 public:
 	SolverBase();
 	virtual ~SolverBase();
-	up::Vec2 kernelGradient(up::Vec2 distanceVector);
+	static up::Vec2 kernelGradient(up::Vec2 distanceVector);
 	virtual void compute() = 0;
 	int numIterations = 0;
 
@@ -17,6 +17,6 @@ protected:
 	static constexpr float radius = 300.0f;
 	static constexpr float KERNEL_SUPPORT = 10.f;
 	static constexpr float PARTICLE_REST_DENSITY = 1.f;
-	float ALPHA = 5.f / (14.f * (float) M_PI * pow(KERNEL_SUPPORT/2, 2));
+	static constexpr float ALPHA = 5.f / (14.f * (float) M_PI * (KERNEL_SUPPORT/2) * (KERNEL_SUPPORT/2));
 };
 
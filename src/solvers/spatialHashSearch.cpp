@@ -0,0 +1,128 @@
+#include "spatialHashSearch.hpp"
+
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+SpatialHashSearch::SpatialHashSearch(ParticleStore * _particles, NeighborList * _neighbors)
+{
+	particles = _particles;
+	neighbors = _neighbors;
+}
+
+void SpatialHashSearch::compute() {
+	NeighborList &list = *neighbors;
+	size_t numParticles = particles->size();
+
+	buildTable();
+
+	//Gather the rows of blocks of consecutive positions into chunk local buffers
+	chunks.resize((numParticles + POSITIONS_PER_CHUNK - 1) / POSITIONS_PER_CHUNK);
+	neighborCounts.resize(numParticles);
+	list.boundaryOffsets.resize(numParticles);
+
+	for (size_t c = 0; c < chunks.size(); c++)
+	{
+		chunks[c].firstPosition = c * POSITIONS_PER_CHUNK;
+		chunks[c].lastPosition = std::min(numParticles, (c + 1) * POSITIONS_PER_CHUNK);
+	}
+
+	std::for_each(
+		std::execution::par,
+		chunks.begin(),
+		chunks.end(),
+		[this](NeighborChunk &chunk) { gatherChunk(chunk); });
+
+	mergeNeighborChunks(chunks, sortOrder, neighborCounts, list);
+
+	list.isSymmetric = false;
+	list.mirror = {};
+	list.clearCellPairs();
+	list.hasSkin = false;
+	list.support = KERNEL_SUPPORT;
+}
+
+SpatialHashSearch::Cell SpatialHashSearch::cellOf(up::Vec2 position)
+{
+	return { (int32_t)std::floor(position.x / KERNEL_SUPPORT), (int32_t)std::floor(position.y / KERNEL_SUPPORT) };
+}
+
+//Sorts the particles by bucket and records the range of every bucket in the table.
+//Distinct cells may share a bucket, so the cell of every sorted particle is kept for the lookups.
+void SpatialHashSearch::buildTable()
+{
+	const ParticleStore &ps = *particles;
+	size_t numParticles = ps.size();
+
+	size_t tableSize = 16;
+	while (tableSize < 2 * numParticles) tableSize *= 2;
+
+	table.resize(tableSize);
+	cells.resize(numParticles);
+	bucketKeys.resize(numParticles);
+	sortedCells.resize(numParticles);
+
+	up::parallelFor(tableSize, [this](size_t bucket) { table[bucket] = { 0, 0 }; });
+
+	up::parallelFor(
+		numParticles,
+		[this, &ps](size_t i)
+		{
+			cells[i] = cellOf(ps.position[i]);
+			bucketKeys[i] = (uint32_t)bucketOf(cells[i]);
+		});
+
+	radixSorter.sort(bucketKeys, sortOrder);
+
+	const std::vector<uint32_t> &keys = radixSorter.sortedKeys();
+
+	up::parallelFor(
+		numParticles,
+		[this, &keys, numParticles](size_t i)
+		{
+			sortedCells[i] = cells[sortOrder[i]];
+
+			if (i == 0 || keys[i] != keys[i - 1]) table[keys[i]].first = (uint32_t)i;
+			if (i + 1 == numParticles || keys[i] != keys[i + 1]) table[keys[i]].last = (uint32_t)(i + 1);
+		});
+}
+
+//Collects the rows of the chunk's particles, fluid neighbors first. Entries of other cells that
+//share a bucket with a stencil cell are skipped, which also keeps a neighbor from being found twice.
+void SpatialHashSearch::gatherChunk(NeighborChunk &chunk)
+{
+	const ParticleStore &ps = *particles;
+	NeighborList &list = *neighbors;
+
+	chunk.clear();
+
+	for (size_t position = chunk.firstPosition; position < chunk.lastPosition; position++)
+	{
+		uint32_t k = sortOrder[position];
+		Cell cell = sortedCells[position];
+
+		chunk.beginRow();
+
+		for (int32_t dy = -1; dy <= 1; dy++)
+		{
+			for (int32_t dx = -1; dx <= 1; dx++)
+			{
+				Cell neighborCell = { cell.x + dx, cell.y + dy };
+				const Bucket &bucket = table[bucketOf(neighborCell)];
+
+				for (uint32_t neighborPosition = bucket.first; neighborPosition < bucket.last; neighborPosition++)
+				{
+					if (!(sortedCells[neighborPosition] == neighborCell)) continue;
+
+					uint32_t l = sortOrder[neighborPosition];
+					up::Vec2 neighborDistance = ps.position[k] - ps.position[l];
+
+					if (neighborDistance.length() < KERNEL_SUPPORT) chunk.add(l, ps.isBoundary[l]);
+				}
+			}
+		}
+
+		chunk.endRow(k, list, neighborCounts);
+	}
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "helpers/neighborChunk.hpp"
+#include "helpers/neighborList.hpp"
+#include "helpers/radixSort.hpp"
+#include "particles/particleStore.hpp"
+#include "solvers/solverBase.hpp"
+
+#include <cstdint>
+#include <vector>
+
+//Neighbor search without a domain: integer cell coordinates are hashed into a table sized by the
+//particle count, so memory does not grow with the area a scene covers. Suits sparse and open scenes
+//(long channels, jets, splashes) where a grid fitted around the particles would be mostly empty.
+//Particle data stays in place, rows are gathered in bucket order.
+class SpatialHashSearch: public SolverBase {
+
+public:
+	SpatialHashSearch(ParticleStore *fParticles, NeighborList *fNeighbors);
+	void compute() override;
+
+private:
+	struct Cell
+	{
+		int32_t x;
+		int32_t y;
+
+		bool operator==(const Cell &other) const { return x == other.x && y == other.y; }
+	};
+
+	//Half open range [first, last) of positions in the bucket order
+	struct Bucket
+	{
+		uint32_t first;
+		uint32_t last;
+	};
+
+	static constexpr size_t POSITIONS_PER_CHUNK = 256;
+
+	ParticleStore *particles;
+	NeighborList *neighbors;
+
+	std::vector<Bucket> table;
+	std::vector<uint32_t> bucketKeys;
+	std::vector<Cell> cells;
+	std::vector<Cell> sortedCells;
+	std::vector<uint32_t> sortOrder;
+	RadixSorter<uint32_t> radixSorter;
+	std::vector<uint32_t> neighborCounts;
+	std::vector<NeighborChunk> chunks;
+
+	static Cell cellOf(up::Vec2 position);
+
+	size_t bucketOf(Cell cell) const
+	{
+		//Large primes decorrelate the axes (Teschner et al. 2003)
+		return (((uint32_t)cell.x * 73856093u) ^ ((uint32_t)cell.y * 19349663u)) & (uint32_t)(table.size() - 1);
+	}
+
+	void buildTable();
+	void gatherChunk(NeighborChunk &chunk);
+};
@@ -0,0 +1,77 @@
+#include "stateEquationSolver.hpp"
+#include "helpers/parallel.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+StateEquationSolver::StateEquationSolver(ParticleStore *_particles, NeighborList *_neighbors, int *_numFluidParticles, float *_stiffness, std::ofstream *_simDataFile)
+{
+	particles = _particles;
+	neighbors = _neighbors;
+	numFluidParticles = _numFluidParticles;
+	stiffness = _stiffness;
+	simDataFile = _simDataFile;
+}
+
+//One pass for the pressures and one for the accelerations, the latter reads the neighbors' pressures
+void StateEquationSolver::compute()
+{
+	ParticleStore &ps = *particles;
+
+	float densityErrorSum = up::parallelSum<float>(
+		ps.size(),
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return 0.f;
+
+			float densityError = std::max(ps.density[i] - PARTICLE_REST_DENSITY, 0.f);
+			ps.pressure[i] = (*stiffness) * densityError;
+
+			return densityError;
+		});
+
+	up::parallelFor(
+		ps.size(),
+		[this, &ps](size_t i)
+		{
+			if (ps.isBoundary[i]) return;
+
+			ps.pressureAcceleration[i] = computePressureAcceleration(i);
+		});
+
+	numIterations = 1;
+
+	writeStatistics(densityErrorSum / PARTICLE_REST_DENSITY / *numFluidParticles);
+}
+
+//The symmetric pressure acceleration of PressureSolver, boundary particles mirror the pressure of particle i
+up::Vec2 StateEquationSolver::computePressureAcceleration(size_t i) const
+{
+	const ParticleStore &ps = *particles;
+	up::Vec2 fluidTerm = { 0.f, 0.f };
+	up::Vec2 boundaryTerm = { 0.f, 0.f };
+
+	neighbors->forEachFluid(i, ps, [&](size_t p, uint32_t j)
+		{
+			fluidTerm += ps.mass[j] * ((ps.pressure[i] + ps.pressure[j]) / restDensitySquared) * pairGradient(p, i, j);
+		});
+
+	neighbors->forEachBoundary(i, ps, [&](size_t p, uint32_t j)
+		{
+			boundaryTerm += ps.mass[j] * 2 * (ps.pressure[i] / restDensitySquared) * pairGradient(p, i, j);
+		});
+
+	return -1 * fluidTerm - gamma * boundaryTerm;
+}
+
+//Writes the solver columns of the current data file row, the same columns as PressureSolver.
+//There is no predicted density error and no divergence solve.
+void StateEquationSolver::writeStatistics(float densityErrorAvg)
+{
+	size_t selected = up::parallelMin(particles->size(), SIZE_MAX, [this](size_t i) { return particles->theOne[i] ? i : SIZE_MAX; });
+	float predictedVelocity = selected != SIZE_MAX ? particles->predictedVelocity[selected].length() : 0.f;
+	float velocity = selected != SIZE_MAX ? particles->velocity[selected].length() : 0.f;
+
+	*simDataFile << "," << numIterations << "," << densityErrorAvg << "," << 0.f <<
+		"," << predictedVelocity << "," << velocity << "," << 0;
+}
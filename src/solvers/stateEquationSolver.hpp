@@ -0,0 +1,40 @@
+#pragma once
+
+#include "helpers/neighborList.hpp"
+#include "particles/particleStore.hpp"
+#include "solvers/solverBase.hpp"
+
+#include <fstream>
+
+//Weakly compressible SPH: the pressure follows from the density through the state equation
+//p_i = max(stiffness * (rho_i - rho_0), 0) in a single explicit pass, without iterating. Meant for quick previews,
+//the density error depends on stiffness and time step instead of being bounded by a tolerance.
+//There is no linear system, so it has none of the warm start, active set or source term setup of PressureSolver.
+class StateEquationSolver: public SolverBase {
+
+public:
+	StateEquationSolver(ParticleStore *_particles, NeighborList *_neighbors, int *_numFluidParticles, float *_stiffness, std::ofstream *_simDataFile);
+	void compute() override;
+
+private:
+	int *numFluidParticles;
+	float *stiffness;
+	std::ofstream *simDataFile;
+	ParticleStore *particles;
+	NeighborList *neighbors;
+
+	float gamma = 1.f;
+	float restDensitySquared = PARTICLE_REST_DENSITY * PARTICLE_REST_DENSITY;
+
+	//Kernel gradient of pair p between particle i and its neighbor j, read from the pair cache when enabled
+	up::Vec2 pairGradient(size_t p, size_t i, size_t j) const
+	{
+		if (neighbors->hasPairCache) return neighbors->kernelGradients[p];
+
+		up::Vec2 distanceVector = particles->position[i] - particles->position[j];
+		return neighbors->inSupport(distanceVector) ? kernelGradient(distanceVector) : up::Vec2(0.f, 0.f);
+	}
+
+	up::Vec2 computePressureAcceleration(size_t i) const;
+	void writeStatistics(float densityErrorAvg);
+};